@@ -0,0 +1,196 @@
+// Microbenchmarks for the Scene/ComponentPool core. Every scenario runs the
+// full entity lifecycle on a fresh scene and times each phase separately.
+// Results are printed as JSON, or written to the file given as first argument.
+// Handles kept from before the destroy phase must no longer reach the entities
+// that recycle their slots, the run fails if any does.
+//
+//   ecs_benchmark [output.json]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+#include "SceneView.h"
+#include "components/Components.h"
+
+namespace {
+
+const size_t ENTITY_COUNTS[] = { 1000, 10000, 100000, 1000000 };
+// Fraction of the entities that get the VelocityComponent
+const double DENSITIES[] = { 0.01, 0.1, 0.5, 1.0 };
+// Small scenes repeat so every measurement covers about a million operations
+const size_t OPERATIONS_PER_SCENARIO = 1000000;
+const size_t MAX_REPETITIONS = 50;
+
+enum Phase {
+    NEW_ENTITY,
+    ASSIGN,
+    GET,
+    VIEW_EACH,
+    VIEW_ITERATOR,
+    REMOVE_COMPONENT,
+    DESTROY_ENTITY,
+    PHASE_COUNT
+};
+
+const char *PHASE_NAMES[PHASE_COUNT] = {
+    "new_entity", "assign", "get", "view_each", "view_iterator", "remove_component", "destroy_entity"
+};
+
+struct Measurement {
+    double bestSeconds = 0.0;
+    size_t operations = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Spreads the selected entities over the whole index range without a random generator
+bool isSelected(size_t index, double density) {
+    uint32_t hash = static_cast<uint32_t>(index) * 2654435761u;
+    return hash < density * 4294967295.0;
+}
+
+// Keeps results alive so the optimizer cannot drop the measured work
+volatile float g_sink;
+
+void record(Measurement &measurement, Clock::time_point start, size_t operations) {
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (measurement.operations == 0 || seconds < measurement.bestSeconds) {
+        measurement.bestSeconds = seconds;
+    }
+    measurement.operations = operations;
+}
+
+// Returns how many stale handles still reached a component after their slots were recycled
+size_t runLifecycle(size_t entityCount, double density, Measurement (&measurements)[PHASE_COUNT]) {
+    Scene scene;
+    // Views live for the whole scene like in the engine, so their upkeep is part of each phase
+    SceneView<PositionComponent, VelocityComponent> view(&scene);
+
+    std::vector<EntityID> ids(entityCount);
+    auto start = Clock::now();
+    for (size_t i = 0; i < entityCount; i++) {
+        ids[i] = scene.NewEntity();
+    }
+    record(measurements[NEW_ENTITY], start, entityCount);
+
+    std::vector<EntityID> selected;
+    for (size_t i = 0; i < entityCount; i++) {
+        scene.Assign<PositionComponent>(ids[i]);
+        if (isSelected(i, density)) {
+            selected.push_back(ids[i]);
+        }
+    }
+
+    start = Clock::now();
+    for (EntityID id : selected) {
+        scene.Assign<VelocityComponent>(id)->velocity = glm::vec3(1.0f, 2.0f, 0.0f);
+    }
+    record(measurements[ASSIGN], start, selected.size());
+
+    start = Clock::now();
+    float sum = 0.0f;
+    for (EntityID id : ids) {
+        VelocityComponent *velocity = scene.Get<VelocityComponent>(id);
+        if (velocity != nullptr) {
+            sum += velocity->velocity.x;
+        }
+    }
+    record(measurements[GET], start, entityCount);
+
+    start = Clock::now();
+    view.each([](PositionComponent &position, VelocityComponent &velocity) {
+        position.position += velocity.velocity;
+    });
+    record(measurements[VIEW_EACH], start, view.size());
+
+    start = Clock::now();
+    for (EntityID id : view) {
+        sum += scene.Get<PositionComponent>(id)->position.y;
+    }
+    record(measurements[VIEW_ITERATOR], start, view.size());
+    g_sink = sum;
+
+    start = Clock::now();
+    for (EntityID id : selected) {
+        scene.RemoveComponentFromEntity<VelocityComponent>(id);
+    }
+    record(measurements[REMOVE_COMPONENT], start, selected.size());
+
+    start = Clock::now();
+    for (EntityID id : ids) {
+        scene.DestroyEntity(id);
+    }
+    record(measurements[DESTROY_ENTITY], start, entityCount);
+
+    for (size_t i = 0; i < entityCount; i++) {
+        scene.Assign<PositionComponent>(scene.NewEntity());
+    }
+    size_t staleHits = 0;
+    for (EntityID id : ids) {
+        if (scene.Get<PositionComponent>(id) != nullptr || scene.Assign<VelocityComponent>(id) != nullptr) {
+            staleHits++;
+        }
+    }
+    return staleHits;
+}
+
+void writeJson(FILE *out, const std::vector<std::string> &results) {
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        std::fprintf(out, "    %s%s\n", results[i].c_str(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> results;
+    size_t staleHits = 0;
+
+    for (size_t entityCount : ENTITY_COUNTS) {
+        for (double density : DENSITIES) {
+            size_t repetitions = std::clamp<size_t>(OPERATIONS_PER_SCENARIO / entityCount, 1, MAX_REPETITIONS);
+            Measurement measurements[PHASE_COUNT];
+            for (size_t run = 0; run < repetitions; run++) {
+                staleHits += runLifecycle(entityCount, density, measurements);
+            }
+
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                const Measurement &measurement = measurements[phase];
+                double nsPerOp = measurement.operations > 0 ? measurement.bestSeconds * 1e9 / measurement.operations : 0.0;
+                char line[256];
+                std::snprintf(line, sizeof(line),
+                    "{\"name\": \"%s\", \"entities\": %zu, \"density\": %.2f, \"operations\": %zu, "
+                    "\"repetitions\": %zu, \"total_ms\": %.4f, \"ns_per_op\": %.3f}",
+                    PHASE_NAMES[phase], entityCount, density, measurement.operations,
+                    repetitions, measurement.bestSeconds * 1e3, nsPerOp);
+                results.push_back(line);
+            }
+            std::fprintf(stderr, "%zu entities, density %.2f done\n", entityCount, density);
+        }
+    }
+
+    if (argc > 1) {
+        FILE *out = std::fopen(argv[1], "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "Could not open %s for writing\n", argv[1]);
+            return 1;
+        }
+        writeJson(out, results);
+        std::fclose(out);
+    } else {
+        writeJson(stdout, results);
+    }
+
+    if (staleHits > 0) {
+        std::fprintf(stderr, "%zu stale handles reached a recycled entity\n", staleHits);
+        return 1;
+    }
+    return 0;
+}
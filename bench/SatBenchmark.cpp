@@ -0,0 +1,174 @@
+// Separating axis kernels: every supported kernel is first checked bit for
+// bit against the scalar one on random shape pairs, then timed. Results are
+// printed as JSON, or written to the file given as first argument. Exits
+// with 1 when a kernel disagrees with the scalar one.
+//
+//   sat_benchmark [output.json]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "physics/SatKernels.h"
+#include "physics/Transformations.h"
+
+namespace {
+
+const size_t PAIR_COUNT = 100000;
+const size_t TIMED_RUNS = 5;
+const SatKernels::Kind KINDS[] = { SatKernels::Kind::Scalar, SatKernels::Kind::SSE2, SatKernels::Kind::AVX2 };
+
+struct Shape {
+    ShapeVertices vertices;
+    ShapeVertices normals;
+};
+
+struct Scenario {
+    const char *name;
+    std::vector<Shape> shapes;
+    // Axes of each pair, the first two normals of a box or every normal of a polygon
+    std::vector<glm::vec3> axes;
+    std::vector<size_t> axisOffsets;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Convex polygon with vertexCount corners on an ellipse, rotated and moved to center
+Shape makeShape(size_t vertexCount, float radiusX, float radiusY, float angle, const glm::vec3 &center) {
+    Shape shape;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    for (size_t i = 0; i < vertexCount; i++) {
+        // Box corners are offset by half a step so they sit on the diagonals
+        float t = 6.2831853f * (float(i) + (vertexCount == BOX_VERTICES ? 0.5f : 0.0f)) / float(vertexCount);
+        float x = radiusX * std::cos(t);
+        float y = radiusY * std::sin(t);
+        shape.vertices.push_back(glm::vec3(c * x - s * y + center.x, s * x + c * y + center.y, 0.0f));
+    }
+    Transformations::computeEdgeNormals(shape.vertices, shape.normals);
+    return shape;
+}
+
+// Pairs close enough that about half of them overlap
+Scenario makeScenario(const char *name, bool boxes, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<size_t> vertexCount(3, MAX_POLYGON_VERTICES);
+
+    Scenario scenario{ name, {}, {}, {} };
+    for (size_t i = 0; i < 2 * PAIR_COUNT; i++) {
+        size_t count = boxes ? BOX_VERTICES : vertexCount(rng);
+        glm::vec3 center(unit(rng) * 0.6f, unit(rng) * 0.6f, 0.0f);
+        scenario.shapes.push_back(makeShape(count, 0.1f + 0.2f * unit(rng), 0.1f + 0.2f * unit(rng), 6.2831853f * unit(rng), center));
+    }
+    for (size_t pair = 0; pair < PAIR_COUNT; pair++) {
+        scenario.axisOffsets.push_back(scenario.axes.size());
+        for (size_t side = 0; side < 2; side++) {
+            const ShapeVertices &normals = scenario.shapes[2 * pair + side].normals;
+            size_t axisCount = boxes ? 2 : normals.size();
+            scenario.axes.insert(scenario.axes.end(), normals.begin(), normals.begin() + axisCount);
+        }
+    }
+    scenario.axisOffsets.push_back(scenario.axes.size());
+    return scenario;
+}
+
+struct Result {
+    bool overlapping;
+    size_t axis;
+    float depth;
+};
+
+Result run(SatKernels::Kind kind, const Scenario &scenario, size_t pair) {
+    Result result{ false, 0, 0.0f };
+    size_t first = scenario.axisOffsets[pair];
+    size_t axisCount = scenario.axisOffsets[pair + 1] - first;
+    result.overlapping = SatKernels::findMinimumOverlap(kind, scenario.axes.data() + first, axisCount,
+        scenario.shapes[2 * pair].vertices, scenario.shapes[2 * pair + 1].vertices, result.axis, result.depth);
+    return result;
+}
+
+bool sameResult(const Result &left, const Result &right) {
+    if (left.overlapping != right.overlapping) {
+        return false;
+    }
+    return !left.overlapping || (left.axis == right.axis && std::memcmp(&left.depth, &right.depth, sizeof(float)) == 0);
+}
+
+void writeJson(FILE *out, const std::vector<std::string> &results) {
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        std::fprintf(out, "    %s%s\n", results[i].c_str(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rng(12345);
+    Scenario scenarios[] = { makeScenario("box_box", true, rng), makeScenario("polygon_polygon", false, rng) };
+
+    std::vector<std::string> results;
+    size_t totalMismatches = 0;
+    for (const Scenario &scenario : scenarios) {
+        for (SatKernels::Kind kind : KINDS) {
+            if (!SatKernels::supported(kind)) {
+                std::fprintf(stderr, "%s: %s not supported here, skipped\n", scenario.name, SatKernels::name(kind));
+                continue;
+            }
+
+            size_t mismatches = 0;
+            size_t overlapping = 0;
+            for (size_t pair = 0; pair < PAIR_COUNT; pair++) {
+                Result expected = run(SatKernels::Kind::Scalar, scenario, pair);
+                Result actual = run(kind, scenario, pair);
+                mismatches += sameResult(expected, actual) ? 0 : 1;
+                overlapping += expected.overlapping ? 1 : 0;
+            }
+            totalMismatches += mismatches;
+
+            double bestSeconds = 0.0;
+            size_t sink = 0;
+            for (size_t timedRun = 0; timedRun < TIMED_RUNS; timedRun++) {
+                Clock::time_point start = Clock::now();
+                for (size_t pair = 0; pair < PAIR_COUNT; pair++) {
+                    sink += run(kind, scenario, pair).axis;
+                }
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                if (timedRun == 0 || seconds < bestSeconds) {
+                    bestSeconds = seconds;
+                }
+            }
+
+            char line[256];
+            std::snprintf(line, sizeof(line),
+                "{\"name\": \"%s\", \"kernel\": \"%s\", \"pairs\": %zu, \"overlapping\": %zu, "
+                "\"mismatches\": %zu, \"ns_per_pair\": %.3f, \"sink\": %zu}",
+                scenario.name, SatKernels::name(kind), PAIR_COUNT, overlapping, mismatches,
+                bestSeconds * 1e9 / PAIR_COUNT, sink % 2);
+            results.push_back(line);
+        }
+    }
+
+    if (argc > 1) {
+        FILE *out = std::fopen(argv[1], "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "Could not open %s for writing\n", argv[1]);
+            return 1;
+        }
+        writeJson(out, results);
+        std::fclose(out);
+    } else {
+        writeJson(stdout, results);
+    }
+
+    if (totalMismatches > 0) {
+        std::fprintf(stderr, "%zu results differ from the scalar kernel\n", totalMismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Contact solver threads and kernels. The same settling pile is stepped with
+// 1, 2, 4, ... solver threads up to the core count, and every run must end
+// bit for bit where the single threaded one did. The contacts of the last
+// step are then solved alone with every supported kernel, which must leave
+// the same velocities as the scalar one. Timings are printed as JSON, or
+// written to the file given as first argument. Exits with 1 when a run differs.
+//
+//   solver_benchmark [output.json] [bodies]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "World.h"
+
+namespace {
+
+const size_t DEFAULT_BODY_COUNT = 4000;
+const size_t COLUMNS = 100;
+// Steps before timing so the pile is already in contact, then timed steps
+const int WARMUP_STEPS = 60;
+const int TIMED_STEPS = 120;
+const float TIME_STEP = 1.0f / 60.0f;
+const int VELOCITY_ITERATIONS = 8;
+const size_t TIMED_SOLVES = 20;
+const SatKernels::Kind KINDS[] = { SatKernels::Kind::Scalar, SatKernels::Kind::SSE2, SatKernels::Kind::AVX2 };
+
+using Clock = std::chrono::steady_clock;
+
+// Boxes and circles dropped in rows into a walled floor
+void buildPile(World &world, size_t bodyCount) {
+    world.insertStaticBox(glm::vec3(0.0f, -3.0f, 0.0f), 12.0f, 0.2f, glm::vec4(1.0f));
+    world.insertStaticBox(glm::vec3(-6.0f, 0.0f, 0.0f), 0.2f, 6.0f, glm::vec4(1.0f));
+    world.insertStaticBox(glm::vec3(6.0f, 0.0f, 0.0f), 0.2f, 6.0f, glm::vec4(1.0f));
+    for (size_t i = 0; i < bodyCount; i++) {
+        // Every other row is shifted a little so the pile does not stand still
+        float x = -5.5f + 0.11f * float(i % COLUMNS) + 0.01f * float((i / COLUMNS) % 2);
+        float y = -2.8f + 0.11f * float(i / COLUMNS);
+        if (i % 3 == 0) {
+            world.insertCircle(x, y, 0.05f, glm::vec4(1.0f));
+        } else {
+            world.insertBox(glm::vec3(x, y, 0.0f), 0.1f, 0.1f, glm::vec4(1.0f));
+        }
+    }
+}
+
+std::vector<float> bodyState(const RigidBodies &bodies) {
+    std::vector<float> state;
+    state.reserve(bodies.size() * 6);
+    for (size_t i = 0; i < bodies.size(); i++) {
+        state.insert(state.end(), { bodies.x[i], bodies.y[i], bodies.angle[i], bodies.vx[i], bodies.vy[i], bodies.omega[i] });
+    }
+    return state;
+}
+
+void writeJson(FILE *out, const std::vector<std::string> &results) {
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        std::fprintf(out, "    %s%s\n", results[i].c_str(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t bodyCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : DEFAULT_BODY_COUNT;
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    std::vector<std::string> results;
+    std::vector<float> expected;
+    size_t mismatches = 0;
+    // Contacts and bodies right after the last step of the single threaded run
+    ContactSolver lastContacts;
+    RigidBodies lastBodies;
+    for (unsigned int threads : threadCounts) {
+        World world;
+        buildPile(world, bodyCount);
+        world.setSolverThreads(threads);
+        for (int step = 0; step < WARMUP_STEPS; step++) {
+            world.step(TIME_STEP);
+        }
+
+        Clock::time_point start = Clock::now();
+        for (int step = 0; step < TIMED_STEPS; step++) {
+            world.step(TIME_STEP);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<float> state = bodyState(world.scene().rigidBodies);
+        if (expected.empty()) {
+            expected = state;
+        }
+        bool matches = state.size() == expected.size() &&
+            std::memcmp(state.data(), expected.data(), state.size() * sizeof(float)) == 0;
+        mismatches += matches ? 0 : 1;
+
+        char line[256];
+        std::snprintf(line, sizeof(line),
+            "{\"name\": \"pile\", \"bodies\": %zu, \"threads\": %u, \"contacts\": %zu, \"colors\": %zu, "
+            "\"matches_single_thread\": %s, \"ms_per_step\": %.3f}",
+            bodyCount, threads, world.contactSolver().constraints().size(), world.contactSolver().colorCount(),
+            matches ? "true" : "false", seconds * 1e3 / TIMED_STEPS);
+        results.push_back(line);
+        if (threads == 1) {
+            lastContacts = world.contactSolver();
+            lastBodies = world.scene().rigidBodies;
+        }
+    }
+
+    std::vector<float> expectedSolved;
+    for (SatKernels::Kind kind : KINDS) {
+        if (!SatKernels::supported(kind)) {
+            std::fprintf(stderr, "%s not supported here, skipped\n", SatKernels::name(kind));
+            continue;
+        }
+
+        double bestSeconds = 0.0;
+        std::vector<float> solved;
+        for (size_t timedRun = 0; timedRun < TIMED_SOLVES; timedRun++) {
+            ContactSolver solver = lastContacts;
+            RigidBodies bodies = lastBodies;
+            solver.setKernel(kind);
+            Clock::time_point start = Clock::now();
+            solver.solve(bodies, VELOCITY_ITERATIONS);
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (timedRun == 0 || seconds < bestSeconds) {
+                bestSeconds = seconds;
+            }
+            solved = bodyState(bodies);
+        }
+
+        if (expectedSolved.empty()) {
+            expectedSolved = solved;
+        }
+        bool matches = solved.size() == expectedSolved.size() &&
+            std::memcmp(solved.data(), expectedSolved.data(), solved.size() * sizeof(float)) == 0;
+        mismatches += matches ? 0 : 1;
+
+        char line[256];
+        std::snprintf(line, sizeof(line),
+            "{\"name\": \"solve\", \"bodies\": %zu, \"kernel\": \"%s\", \"contacts\": %zu, \"iterations\": %d, "
+            "\"matches_scalar\": %s, \"us_per_solve\": %.3f}",
+            bodyCount, SatKernels::name(kind), lastContacts.constraints().size(), VELOCITY_ITERATIONS,
+            matches ? "true" : "false", bestSeconds * 1e6);
+        results.push_back(line);
+    }
+
+    if (argc > 1) {
+        FILE *out = std::fopen(argv[1], "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "Could not open %s for writing\n", argv[1]);
+            return 1;
+        }
+        writeJson(out, results);
+        std::fclose(out);
+    } else {
+        writeJson(stdout, results);
+    }
+
+    if (mismatches > 0) {
+        std::fprintf(stderr, "%zu runs differ from the single threaded or scalar one\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "CommandBuffer.h"
+
+static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+CommandBuffer::~CommandBuffer() {
+    releasePayloads();
+    for (Block &block : m_blocks) {
+        ::operator delete(block.data, std::align_val_t(BLOCK_ALIGNMENT));
+    }
+}
+
+void CommandBuffer::Playback() {
+    // IDs reserved by NewEntity become live before any command refers to them
+    m_scene.FlushReservedEntities();
+
+    for (const Command &command : m_commands) {
+        command.apply(m_scene, command.id, command.payload);
+    }
+
+    releasePayloads();
+    m_commands.clear();
+    m_currentBlock = 0;
+    m_blockOffset = 0;
+}
+
+void* CommandBuffer::allocate(size_t size, size_t alignment) {
+    while (m_currentBlock < m_blocks.size()) {
+        Block &block = m_blocks[m_currentBlock];
+        size_t offset = (m_blockOffset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= block.size) {
+            m_blockOffset = offset + size;
+            return block.data + offset;
+        }
+        m_currentBlock++;
+        m_blockOffset = 0;
+    }
+
+    // Oversized components get a block of their own
+    size_t blockSize = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+    char *data = static_cast<char*>(::operator new(blockSize, std::align_val_t(BLOCK_ALIGNMENT)));
+    m_blocks.push_back({ data, blockSize });
+    m_currentBlock = m_blocks.size() - 1;
+    m_blockOffset = size;
+    return data;
+}
+
+void CommandBuffer::releasePayloads() {
+    for (const Command &command : m_commands) {
+        if (command.destroy != nullptr) {
+            command.destroy(command.payload);
+        }
+    }
+}
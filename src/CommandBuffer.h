@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Scene.h"
+
+// Records structural changes (create, assign, remove, destroy) so systems
+// running on worker threads never touch Scene's entity table or pools.
+// Use one buffer per thread and call Playback from the main thread at a
+// sync point, commands are applied in the order they were recorded.
+// Assigns to an ID that is not alive when they are applied, because a
+// command before them in this or another buffer destroyed it, are dropped.
+class CommandBuffer {
+public:
+    explicit CommandBuffer(Scene &scene): m_scene(scene) {}
+    ~CommandBuffer();
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    // The returned ID is reserved atomically and can be used by later commands
+    EntityID NewEntity() {
+        return m_scene.ReserveEntity();
+    }
+
+    // Returns a staged component to fill in, it is moved into the scene on Playback
+    template<typename T>
+    T* Assign(EntityID id) {
+        static_assert(alignof(T) <= 64, "Component alignment exceeds the block alignment");
+        static_assert(!std::is_same_v<T, RigidBodyComponent>, "The scene picks the body slot, stage the body with AssignRigidBody");
+        Command command{ id, nullptr, &ApplyAssign<T>, nullptr };
+        if constexpr (!std::is_empty_v<T>) {
+            command.payload = new (allocate(sizeof(T), alignof(T))) T();
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                command.destroy = &DestroyPayload<T>;
+            }
+        }
+        m_commands.push_back(command);
+        return command.payload == nullptr ? &s_emptyComponent<T> : static_cast<T*>(command.payload);
+    }
+
+    // Returns a staged body to fill in. Playback assigns a RigidBodyComponent
+    // whose body starts from it
+    RigidBodyState* AssignRigidBody(EntityID id) {
+        Command command{ id, nullptr, &ApplyAssignRigidBody, nullptr };
+        command.payload = new (allocate(sizeof(RigidBodyState), alignof(RigidBodyState))) RigidBodyState();
+        m_commands.push_back(command);
+        return static_cast<RigidBodyState*>(command.payload);
+    }
+
+    template<typename T>
+    void RemoveComponentFromEntity(EntityID id) {
+        m_commands.push_back({ id, nullptr, &ApplyRemove<T>, nullptr });
+    }
+
+    void DestroyEntity(EntityID id) {
+        m_commands.push_back({ id, nullptr, &ApplyDestroy, nullptr });
+    }
+
+    bool Empty() const {
+        return m_commands.empty();
+    }
+
+    // Applies every recorded command to the scene and clears the buffer
+    void Playback();
+
+private:
+    struct Command {
+        EntityID id;
+        void *payload;
+        void (*apply)(Scene &scene, EntityID id, void *payload);
+        void (*destroy)(void *payload);
+    };
+
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    template<typename T>
+    static void ApplyAssign(Scene &scene, EntityID id, void *payload) {
+        if (!scene.IsAlive(id)) {
+            return;
+        }
+        T *component = scene.Assign<T>(id);
+        if constexpr (!std::is_empty_v<T>) {
+            *component = std::move(*static_cast<T*>(payload));
+        }
+    }
+
+    static void ApplyAssignRigidBody(Scene &scene, EntityID id, void *payload) {
+        if (!scene.IsAlive(id)) {
+            return;
+        }
+        scene.AssignRigidBody(id, *static_cast<const RigidBodyState*>(payload));
+    }
+
+    template<typename T>
+    static void ApplyRemove(Scene &scene, EntityID id, void *) {
+        scene.RemoveComponentFromEntity<T>(id);
+    }
+
+    static void ApplyDestroy(Scene &scene, EntityID id, void *) {
+        scene.DestroyEntity(id);
+    }
+
+    template<typename T>
+    static void DestroyPayload(void *payload) {
+        static_cast<T*>(payload)->~T();
+    }
+
+    // Bump allocation from blocks that never move, so staged pointers stay valid
+    void* allocate(size_t size, size_t alignment);
+    void releasePayloads();
+
+    Scene &m_scene;
+    std::vector<Command> m_commands;
+    std::vector<Block> m_blocks;
+    size_t m_currentBlock = 0;
+    size_t m_blockOffset = 0;
+};
@@ -1 +1,39 @@
-#include "ComponentPool.h"
\ No newline at end of file
+#include "ComponentPool.h"
+
+#include <new>
+
+ComponentPool::~ComponentPool() {
+    for (char *page : pages) {
+        if (page != nullptr) {
+            ::operator delete(page, std::align_val_t(POOL_PAGE_ALIGNMENT));
+        }
+    }
+}
+
+void ComponentPool::releasePagesFrom(size_t firstIndex) {
+    size_t firstPage = (firstIndex + POOL_PAGE_MASK) >> POOL_PAGE_SHIFT;
+    for (size_t page = firstPage; page < pages.size(); page++) {
+        if (pages[page] != nullptr) {
+            ::operator delete(pages[page], std::align_val_t(POOL_PAGE_ALIGNMENT));
+            pages[page] = nullptr;
+            pageTicks[page] = 0;
+            allocatedPages--;
+        }
+    }
+}
+
+void* ComponentPool::ensure(size_t index) {
+    size_t page = index >> POOL_PAGE_SHIFT;
+    if (page >= pages.size()) {
+        pages.resize(page + 1, nullptr);
+        pageTicks.resize(page + 1, 0);
+    }
+
+    if (pages[page] == nullptr) {
+        pages[page] = static_cast<char*>(::operator new(pageBytes(), std::align_val_t(POOL_PAGE_ALIGNMENT)));
+        pageTicks[page] = 0;
+        allocatedPages++;
+    }
+
+    return get(index);
+}
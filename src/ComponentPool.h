@@ -1,20 +1,109 @@
 #pragma once
 #include <cstddef>
-static constexpr int MAX_ENTITIES = 1000;
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Components live in fixed-size pages that are allocated the first time an
+// entity index inside them is used, so memory grows with the live entities.
+static constexpr size_t POOL_PAGE_SHIFT = 10;
+static constexpr size_t POOL_PAGE_ELEMENTS = size_t(1) << POOL_PAGE_SHIFT;
+static constexpr size_t POOL_PAGE_MASK = POOL_PAGE_ELEMENTS - 1;
+static constexpr size_t POOL_PAGE_ALIGNMENT = 64;
+
+// Scene tick at which a component was last written, see Scene::MarkChanged
+typedef uint32_t ChangeTick;
 
 struct ComponentPool {
-    char *pData{ nullptr };
+    std::vector<char*> pages;
+    // Newest change tick written in each page, so change scans can skip whole pages
+    std::vector<ChangeTick> pageTicks;
     size_t elementSize = 0;
+    size_t allocatedPages = 0;
+
+    explicit ComponentPool(size_t elementSize): elementSize(elementSize) {}
+    virtual ~ComponentPool();
+
+    ComponentPool(const ComponentPool&) = delete;
+    ComponentPool& operator=(const ComponentPool&) = delete;
+
+    // Element at index, the page holding it must already exist
+    void* get(size_t index) const {
+        return pages[index >> POOL_PAGE_SHIFT] + (index & POOL_PAGE_MASK) * elementSize;
+    }
+
+    // Element at index, allocating its page if needed
+    void* ensure(size_t index);
+
+    // Frees every page that only holds indices at or above firstIndex. Those slots must be empty
+    void releasePagesFrom(size_t firstIndex);
+
+    // Each page stores its change ticks right after the elements
+    ChangeTick changeTick(size_t index) const {
+        return pageChangeTicks(index)[index & POOL_PAGE_MASK];
+    }
+
+    void setChangeTick(size_t index, ChangeTick tick) {
+        pageChangeTicks(index)[index & POOL_PAGE_MASK] = tick;
+        ChangeTick &newest = pageTicks[index >> POOL_PAGE_SHIFT];
+        if (tick > newest) {
+            newest = tick;
+        }
+    }
+
+    // Newest change tick in the page, 0 when the page does not exist
+    ChangeTick pageChangeTick(size_t page) const {
+        return page < pageTicks.size() ? pageTicks[page] : 0;
+    }
+
+    bool hasPage(size_t index) const {
+        size_t page = index >> POOL_PAGE_SHIFT;
+        return page < pages.size() && pages[page] != nullptr;
+    }
+
+    size_t pageBytes() const {
+        return (elementSize + sizeof(ChangeTick)) * POOL_PAGE_ELEMENTS;
+    }
+
+    // Bytes currently reserved by this pool, page table included
+    size_t memoryUsage() const {
+        return allocatedPages * pageBytes() + pages.capacity() * sizeof(char*) + pageTicks.capacity() * sizeof(ChangeTick);
+    }
+
+    // Runs the destructor of the live component at index
+    virtual void destroy(size_t index) = 0;
+
+    // Move-constructs the live component at from into the empty slot to, then destroys from
+    virtual void relocate(size_t from, size_t to) = 0;
+
+private:
+    ChangeTick* pageChangeTicks(size_t index) const {
+        char *page = pages[index >> POOL_PAGE_SHIFT];
+        return reinterpret_cast<ChangeTick*>(page + elementSize * POOL_PAGE_ELEMENTS);
+    }
+};
+
+template<typename T>
+struct TypedComponentPool final : ComponentPool {
+    static_assert(alignof(T) <= POOL_PAGE_ALIGNMENT, "Component alignment exceeds the page alignment");
+
+    TypedComponentPool(): ComponentPool(sizeof(T)) {}
 
-    explicit ComponentPool(size_t elementSize): elementSize(elementSize) {
-        pData = new char[elementSize * MAX_ENTITIES];
+    T* construct(size_t index) {
+        return new (ensure(index)) T();
     }
 
-    ~ComponentPool() {
-        delete[] pData;
+    void destroy(size_t index) override {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            static_cast<T*>(get(index))->~T();
+        }
     }
 
-    void* get(size_t index) {
-        return pData + index * elementSize;
+    void relocate(size_t from, size_t to) override {
+        T *source = static_cast<T*>(get(from));
+        new (ensure(to)) T(std::move(*source));
+        destroy(from);
     }
 };
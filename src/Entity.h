@@ -0,0 +1,26 @@
+#pragma once
+
+// Entity handles, shared by the scene and the physics storage that points back at entities
+typedef unsigned long long EntityID;
+typedef unsigned int EntityIndex;
+typedef unsigned int EntityVersion;
+
+inline EntityID CreateEntityId(EntityIndex index, EntityVersion version) {
+    // Index on top, version on bottom
+    return ((EntityID) index << 32) | ((EntityID) version);
+}
+
+inline EntityIndex GetEntityIndex(EntityID id) {
+    // Shift down 32 to get our index
+    return id >> 32;
+}
+
+inline EntityVersion GetEntityVersion(EntityID id) {
+    // Cast to lose index and get only the version
+    return (EntityVersion)id;
+}
+
+inline bool isEntityValid(EntityID id) {
+    // Check if index is on the valid range
+    return (id >> 32) != EntityIndex(-1);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <type_traits>
+#include <utility>
+
+#include "Scene.h"
+
+// A prebuilt component mask plus a default value for each of its components.
+// Scene::Spawn stamps it onto many entities at once: masks are written in
+// bulk and every component pool is filled in one pass.
+class Prefab {
+public:
+    Prefab() = default;
+    ~Prefab() {
+        for (Entry &entry : entries) {
+            if (entry.destroy != nullptr) {
+                entry.destroy(entry.value);
+            }
+        }
+    }
+
+    Prefab(const Prefab&) = delete;
+    Prefab& operator=(const Prefab&) = delete;
+
+    // Adds T to the prefab and returns its default value to fill in
+    template<typename T>
+    T& Set() {
+        int componentId = GetId<T>();
+        mask.set(componentId);
+        if constexpr (std::is_empty_v<T>) {
+            return s_emptyComponent<T>;
+        } else {
+            Entry &entry = entries[componentId];
+            if (entry.value == nullptr) {
+                entry = { new T(), &Fill<T>, &Destroy<T> };
+            }
+            return *static_cast<T*>(entry.value);
+        }
+    }
+
+    ComponentMask mask;
+    // Initial state of the body when the prefab has a RigidBodyComponent
+    RigidBodyState body;
+
+private:
+    friend struct Scene;
+
+    struct Entry {
+        void *value = nullptr;
+        // Copy-constructs value into the pool slot of every index
+        void (*fill)(Scene &scene, const void *value, const EntityIndex *indices, size_t count) = nullptr;
+        void (*destroy)(void *value) = nullptr;
+    };
+
+    template<typename T>
+    static void Fill(Scene &scene, const void *value, const EntityIndex *indices, size_t count) {
+        TypedComponentPool<T> *pool = scene.GetOrCreatePool<T>();
+        const T &prototype = *static_cast<const T*>(value);
+        for (size_t i = 0; i < count; i++) {
+            new (pool->ensure(indices[i])) T(prototype);
+            pool->setChangeTick(indices[i], scene.currentTick);
+        }
+    }
+
+    template<typename T>
+    static void Destroy(void *value) {
+        delete static_cast<T*>(value);
+    }
+
+    std::array<Entry, COMPONENT_COUNT> entries{};
+};
@@ -1,24 +1,27 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
-#include "Scene.h"
+#include <string>
+
+#include "World.h"
 #include "shader/Shader.h"
 #include "glm/glm.hpp"
 
+// Draws a World with GL and owns the cursor preview circle that lives in it
 class Renderer {
 public:
-    explicit Renderer();
+    explicit Renderer(World &world);
     ~Renderer();
     void draw(Shader &shader);
 
-    EntityID insertCircle(float centerX, float centerY, float radius, const glm::vec4 &color);
-    EntityID insertBox(const glm::vec3& position, float width, float height, const glm::vec4 &color);
-    EntityID insertStaticBox(const glm::vec3& position, float width, float height, const glm::vec4 &color);
     EntityID setHoveredCircle(const glm::vec3 &position, float radius, const glm::vec4 &color);
+    // Advances the world by the frame time in fixed steps and keeps the preview handle valid
     void update(float deltaTime);
+    bool saveSnapshot(const std::string &path);
+    bool loadSnapshot(const std::string &path);
     void setProjection(const glm::mat4 &projection);
 private:
-    Scene m_scene;
+    World &m_world;
     glm::mat4 m_projection;
     unsigned int m_VBO, m_VAO, m_EBO;
     EntityID m_hoveredCircle = std::numeric_limits<EntityID>::max();
@@ -1 +1,336 @@
-#include "Scene.h"
\ No newline at end of file
+#include "Scene.h"
+#include "Prefab.h"
+#include "physics/Transformations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+Scene::~Scene() {
+    for (EntityIndex i = 0; i < entities.size(); i++) {
+        DestroyComponents(i, entities[i].mask);
+    }
+    for (ComponentPool *pool : componentPools) {
+        delete pool;
+    }
+    for (ViewCache *cache : viewCaches) {
+        delete cache;
+    }
+}
+
+void ViewCache::Add(EntityIndex index) {
+    if (positions.size() <= index) {
+        positions.resize(index + 1, NOT_CACHED);
+    }
+    positions[index] = static_cast<unsigned int>(indices.size());
+    indices.push_back(index);
+}
+
+void ViewCache::Remove(EntityIndex index) {
+    // Swap with the last element to keep the list packed
+    unsigned int position = positions[index];
+    EntityIndex last = indices.back();
+    indices[position] = last;
+    positions[last] = position;
+    indices.pop_back();
+    positions[index] = NOT_CACHED;
+}
+
+static void FillViewCache(ViewCache &cache, const std::vector<Scene::EntityDesc> &entities) {
+    for (EntityIndex i = 0; i < entities.size(); i++) {
+        if (cache.Matches(entities[i].mask, isEntityValid(entities[i].id))) {
+            cache.Add(i);
+        }
+    }
+}
+
+ViewCache* Scene::GetViewCache(ComponentMask mask) {
+    for (ViewCache *cache : viewCaches) {
+        if (cache->mask == mask) {
+            return cache;
+        }
+    }
+
+    // First view with this mask, fill it with a full scan once
+    auto *cache = new ViewCache(mask);
+    FillViewCache(*cache, entities);
+    viewCaches.push_back(cache);
+    return cache;
+}
+
+void Scene::RefreshViewCaches() {
+    for (ViewCache *cache : viewCaches) {
+        cache->indices.clear();
+        cache->positions.clear();
+        FillViewCache(*cache, entities);
+    }
+}
+
+void Scene::Clear() {
+    for (EntityIndex i = 0; i < entities.size(); i++) {
+        DestroyComponents(i, entities[i].mask);
+    }
+    entities.clear();
+    freeEntities.clear();
+    freeEntitiesSorted = true;
+    rigidBodies.clear();
+    freeCursor.store(0, std::memory_order_relaxed);
+    remappedEntities.clear();
+    RefreshViewCaches();
+}
+
+std::vector<PoolMemoryInfo> Scene::GetMemoryUsage() const {
+    std::vector<PoolMemoryInfo> usage;
+    for (int i = 0; i < COMPONENT_COUNT; i++) {
+        const ComponentPool *pool = componentPools[i];
+        if (pool == nullptr) {
+            continue;
+        }
+        usage.push_back({ i, pool->elementSize, pool->allocatedPages, pool->memoryUsage() });
+    }
+    return usage;
+}
+
+size_t Scene::Compact(size_t maxMoves) {
+    FlushReservedEntities();
+    if (freeEntities.empty()) {
+        return 0;
+    }
+
+    // Lowest free slot at the back, which is also what NewEntity recycles first
+    if (!freeEntitiesSorted) {
+        std::sort(freeEntities.begin(), freeEntities.end(), std::greater<>());
+        freeEntitiesSorted = true;
+    }
+
+    size_t liveEnd = entities.size();
+    size_t moves = 0;
+    std::vector<EntityID> freedTail;
+    while (true) {
+        while (liveEnd > 0 && !isEntityValid(entities[liveEnd - 1].id)) {
+            liveEnd--;
+        }
+        if (moves == maxMoves || freeEntities.empty() || freeEntities.back() >= liveEnd) {
+            break;
+        }
+
+        EntityIndex to = EntityIndex(freeEntities.back());
+        EntityIndex from = EntityIndex(liveEnd - 1);
+        freeEntities.pop_back();
+        MoveEntity(from, to);
+        freedTail.push_back(from);
+        moves++;
+    }
+    // Freed slots are all above the remaining holes but can interleave with the
+    // dead tail, merge them in so the list stays descending
+    size_t remaining = freeEntities.size();
+    freeEntities.insert(freeEntities.end(), freedTail.begin(), freedTail.end());
+    std::inplace_merge(freeEntities.begin(), freeEntities.begin() + remaining, freeEntities.end(), std::greater<>());
+
+    // The dead tail keeps its slots so versions survive, only the storage goes
+    for (ComponentPool *pool : componentPools) {
+        if (pool != nullptr) {
+            pool->releasePagesFrom(liveEnd);
+        }
+    }
+    freeCursor.store(static_cast<long long>(freeEntities.size()), std::memory_order_relaxed);
+    return moves;
+}
+
+// Interleaves the low 16 bits of x and y into a Z-order curve position
+static uint32_t MortonCode(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0x0000FFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+// Clamps to the 16 bit grid before the cast, NaN lands on 0
+static uint32_t Quantize(float value) {
+    if (!(value > 0.0f)) {
+        return 0;
+    }
+    return value < 65535.0f ? uint32_t(value) : 65535u;
+}
+
+size_t Scene::SortSpatially() {
+    FlushReservedEntities();
+
+    size_t count = rigidBodies.size();
+    if (count < 2) {
+        return 0;
+    }
+
+    // Quantize positions to 16 bits per axis over the bounds of all bodies.
+    // A body that blew up to inf or NaN is left out of the bounds
+    float minX = std::numeric_limits<float>::max(), maxX = -minX;
+    float minY = minX, maxY = maxX;
+    for (size_t i = 0; i < count; i++) {
+        if (std::isfinite(rigidBodies.x[i])) {
+            minX = std::min(minX, rigidBodies.x[i]);
+            maxX = std::max(maxX, rigidBodies.x[i]);
+        }
+        if (std::isfinite(rigidBodies.y[i])) {
+            minY = std::min(minY, rigidBodies.y[i]);
+            maxY = std::max(maxY, rigidBodies.y[i]);
+        }
+    }
+    float scaleX = maxX > minX ? 65535.0f / (maxX - minX) : 0.0f;
+    float scaleY = maxY > minY ? 65535.0f / (maxY - minY) : 0.0f;
+
+    std::vector<std::pair<uint32_t, uint32_t>> keys(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t qx = Quantize((rigidBodies.x[i] - minX) * scaleX);
+        uint32_t qy = Quantize((rigidBodies.y[i] - minY) * scaleY);
+        keys[i] = { MortonCode(qx, qy), uint32_t(i) };
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = keys[i].second;
+    }
+    rigidBodies.permute(order);
+
+    // The slots that hold bodies stay the same, body i goes to the i-th lowest
+    ComponentPool *bodyPool = componentPools[GetId<RigidBodyComponent>()];
+    std::vector<EntityIndex> slots(count);
+    for (size_t i = 0; i < count; i++) {
+        slots[i] = GetEntityIndex(rigidBodies.owners[i]);
+        static_cast<RigidBodyComponent*>(bodyPool->get(slots[i]))->body = uint32_t(i);
+    }
+    std::sort(slots.begin(), slots.end());
+    std::vector<EntityIndex> source(entities.size(), EntityIndex(-1));
+    for (size_t i = 0; i < count; i++) {
+        source[slots[i]] = GetEntityIndex(rigidBodies.owners[i]);
+    }
+
+    // Each permutation cycle parks its first entity in a scratch slot past the end
+    EntityIndex scratch = EntityIndex(entities.size());
+    entities.push_back({ CreateEntityId(EntityIndex(-1), 0), ComponentMask() });
+
+    size_t moves = 0;
+    for (EntityIndex start : slots) {
+        if (source[start] == start) {
+            continue;
+        }
+        EntityID startID = entities[start].id;
+        MoveEntity(start, scratch);
+        EntityID parkedID = entities[scratch].id;
+
+        EntityIndex hole = start;
+        while (source[hole] != start) {
+            EntityIndex from = source[hole];
+            source[hole] = hole;
+            MoveEntity(from, hole);
+            moves++;
+            hole = from;
+        }
+        source[hole] = hole;
+        MoveEntity(scratch, hole);
+        moves++;
+
+        // Skip the scratch ID so the slot can be given out again
+        remappedEntities.erase(parkedID);
+        remappedEntities[startID] = entities[hole].id;
+    }
+
+    entities.pop_back();
+    for (ComponentPool *pool : componentPools) {
+        if (pool != nullptr) {
+            pool->releasePagesFrom(entities.size());
+        }
+    }
+
+    // Caches are refilled in index order, so views walk bodies along the curve
+    RefreshViewCaches();
+    return moves;
+}
+
+void Scene::MoveEntity(EntityIndex from, EntityIndex to) {
+    ComponentMask mask = entities[from].mask;
+    for (int componentId = 0; componentId < COMPONENT_COUNT; componentId++) {
+        ComponentPool *pool = componentPools[componentId];
+        if (!mask.test(componentId) || pool == nullptr) {
+            continue;
+        }
+        ChangeTick tick = pool->changeTick(from);
+        pool->relocate(from, to);
+        pool->setChangeTick(to, tick);
+    }
+
+    EntityID oldID = entities[from].id;
+    EntityID newID = CreateEntityId(to, GetEntityVersion(entities[to].id));
+    if (mask.test(GetId<RigidBodyComponent>())) {
+        rigidBodies.owners[static_cast<RigidBodyComponent*>(componentPools[GetId<RigidBodyComponent>()]->get(to))->body] = newID;
+    }
+    entities[to] = { newID, mask };
+    entities[from] = { CreateEntityId(EntityIndex(-1), GetEntityVersion(oldID) + 1), ComponentMask() };
+    UpdateViewCaches(from, mask, true, ComponentMask(), false);
+    UpdateViewCaches(to, ComponentMask(), false, mask, true);
+    remappedEntities[oldID] = newID;
+}
+
+void Scene::Spawn(const Prefab &prefab, const RigidBodyState *bodies, size_t count, std::vector<EntityID> &spawned) {
+    FlushReservedEntities();
+
+    std::vector<EntityIndex> indices;
+    indices.reserve(count);
+    spawned.reserve(spawned.size() + count);
+
+    // Recycled slots first, then one resize for the rest
+    while (indices.size() < count && !freeEntities.empty()) {
+        EntityIndex index = EntityIndex(freeEntities.back());
+        freeEntities.pop_back();
+        entities[index] = { CreateEntityId(index, GetEntityVersion(entities[index].id)), prefab.mask };
+        indices.push_back(index);
+    }
+    size_t firstNew = entities.size();
+    entities.resize(firstNew + (count - indices.size()));
+    for (size_t index = firstNew; index < entities.size(); index++) {
+        entities[index] = { CreateEntityId(EntityIndex(index), 0), prefab.mask };
+        indices.push_back(EntityIndex(index));
+    }
+    freeCursor.store(static_cast<long long>(freeEntities.size()), std::memory_order_relaxed);
+
+    for (EntityIndex index : indices) {
+        spawned.push_back(entities[index].id);
+    }
+
+    // Column by column, one pass per component pool
+    for (const Prefab::Entry &entry : prefab.entries) {
+        if (entry.fill != nullptr) {
+            entry.fill(*this, entry.value, indices.data(), indices.size());
+        }
+    }
+
+    if (prefab.mask.test(GetId<RigidBodyComponent>())) {
+        rigidBodies.reserve(rigidBodies.size() + count);
+        ComponentPool *pool = componentPools[GetId<RigidBodyComponent>()];
+        ComponentPool *transforms = prefab.mask.test(GetId<TransformComponent>()) ? GetPool<TransformComponent>() : nullptr;
+        for (size_t i = 0; i < count; i++) {
+            EntityIndex index = indices[i];
+            const RigidBodyState &state = bodies != nullptr ? bodies[i] : prefab.body;
+            static_cast<RigidBodyComponent*>(pool->get(index))->body = rigidBodies.add(entities[index].id, state);
+            if (transforms != nullptr) {
+                Transformations::updateMatrix(static_cast<TransformComponent*>(transforms->get(index))->transformMatrix,
+                    glm::vec3(state.x, state.y, 0.0f), state.angle);
+            }
+        }
+    }
+
+    for (ViewCache *cache : viewCaches) {
+        if (cache->Matches(prefab.mask, true)) {
+            cache->indices.reserve(cache->indices.size() + count);
+            for (EntityIndex index : indices) {
+                cache->Add(index);
+            }
+        }
+    }
+}
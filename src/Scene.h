@@ -1,37 +1,61 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <unordered_map>
 #include <vector>
 #include <bitset>
+#include <type_traits>
 
 #include "component.h"
 #include "ComponentPool.h"
+#include "Entity.h"
+#include "physics/RigidBodies.h"
 
-typedef unsigned long long EntityID;
 static constexpr int MAX_COMPONENTS = 32;
 typedef std::bitset<MAX_COMPONENTS> ComponentMask;
+static_assert(COMPONENT_COUNT <= MAX_COMPONENTS, "Too many registered components for ComponentMask");
 
-typedef unsigned int EntityIndex;
-typedef unsigned int EntityVersion;
-
-inline EntityID CreateEntityId(EntityIndex index, EntityVersion version) {
-    // Index on top, version on bottom
-    return ((EntityID) index << 32) | ((EntityID) version);
+// Mask with the bits of every listed component set, usable in constant expressions
+template<typename... ComponentTypes>
+constexpr ComponentMask MakeComponentMask() {
+    return ComponentMask((0ull | ... | (1ull << GetId<ComponentTypes>())));
 }
 
-inline EntityIndex GetEntityIndex(EntityID id) {
-    // Shift down 32 to get our index
-    return id >> 32;
-}
+// Components without data (tags) never get a pool, only a bit in the entity mask.
+// Every entity shares this instance when one is requested.
+template<typename T>
+inline T s_emptyComponent{};
 
-inline EntityVersion GetEntityVersion(EntityID id) {
-    // Cast to lose index and get only the version
-    return (EntityVersion)id;
-}
+class Prefab;
 
-inline bool isEntityValid(EntityID id) {
-    // Check if index is on the valid range
-    return (id >> 32) != EntityIndex(-1);
-}
+struct PoolMemoryInfo {
+    int componentId;
+    size_t elementSize;
+    size_t allocatedPages;
+    size_t bytes;
+};
+
+// Packed list of the live entities whose mask contains a given view mask.
+// Scene keeps it up to date as masks change, so iterating a view only
+// touches the entities that match it.
+struct ViewCache {
+    static constexpr unsigned int NOT_CACHED = ~0u;
+
+    ComponentMask mask;
+    std::vector<EntityIndex> indices;
+    // Position of each entity index inside indices, NOT_CACHED if absent
+    std::vector<unsigned int> positions;
+
+    explicit ViewCache(ComponentMask mask): mask(mask) {}
+
+    bool Matches(ComponentMask entityMask, bool alive) const {
+        return alive && (entityMask & mask) == mask;
+    }
+
+    void Add(EntityIndex index);
+    void Remove(EntityIndex index);
+};
 
 struct Scene {
     struct EntityDesc {
@@ -39,51 +63,169 @@ struct Scene {
         ComponentMask mask;
     };
     std::vector<EntityDesc> entities;
-    std::vector<ComponentPool*> componentPools;
+    // Indexed by component ID, nullptr for tags and types never assigned
+    std::array<ComponentPool*, COMPONENT_COUNT> componentPools{};
     std::vector<EntityID> freeEntities;
+    // Whether freeEntities is still in descending order. Popping from the back
+    // keeps it, Compact only sorts again after a destroy appended out of order
+    bool freeEntitiesSorted = true;
+    std::vector<ViewCache*> viewCaches;
+    // Written into a component's change tick whenever it is assigned or marked changed
+    ChangeTick currentTick = 1;
+    // Entries of freeEntities not yet claimed by ReserveEntity. Once negative,
+    // its magnitude is the number of indices reserved past entities.size()
+    std::atomic<long long> freeCursor{ 0 };
+    // Old ID to new ID for every entity moved by Compact or SortSpatially, see Resolve
+    std::unordered_map<EntityID, EntityID> remappedEntities;
+    // Physics state of every entity with a RigidBodyComponent
+    RigidBodies rigidBodies;
+
+    Scene() = default;
+    ~Scene();
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
 
     EntityID NewEntity() {
-        if (!freeEntities.empty()) {
-            EntityIndex newIndex = freeEntities.back();
-            freeEntities.pop_back();
-            EntityID newID = CreateEntityId(newIndex, GetEntityVersion(entities[newIndex].id));
-            entities[newIndex].id = newID;
+        EntityID newID = ReserveEntity();
+        FlushReservedEntities();
+        return newID;
+    }
+
+    // Safe to call from any thread. Destroyed slots are recycled first, with
+    // the version bumped by DestroyEntity. The ID can be used right away and
+    // becomes a live entity at the next FlushReservedEntities
+    EntityID ReserveEntity() {
+        long long cursor = freeCursor.fetch_sub(1, std::memory_order_relaxed);
+        if (cursor > 0) {
+            EntityIndex index = freeEntities[cursor - 1];
+            return CreateEntityId(index, GetEntityVersion(entities[index].id));
+        }
+        return CreateEntityId(EntityIndex(entities.size() - cursor), 0);
+    }
+
+    // Turns every reserved ID into a live entity, only call it from a sync point
+    void FlushReservedEntities() {
+        long long cursor = freeCursor.load(std::memory_order_relaxed);
+        size_t unclaimed = cursor > 0 ? size_t(cursor) : 0;
+
+        for (size_t i = unclaimed; i < freeEntities.size(); i++) {
+            EntityIndex index = freeEntities[i];
+            entities[index].id = CreateEntityId(index, GetEntityVersion(entities[index].id));
+            UpdateViewCaches(index, ComponentMask(), false, ComponentMask(), true);
+        }
+        freeEntities.resize(unclaimed);
+
+        for (long long i = cursor; i < 0; i++) {
+            entities.push_back({ CreateEntityId(EntityIndex(entities.size()), 0), ComponentMask() });
+            UpdateViewCaches(EntityIndex(entities.size() - 1), ComponentMask(), false, ComponentMask(), true);
         }
-        entities.push_back({ CreateEntityId(EntityIndex(entities.size()), 0), ComponentMask() });
-        return entities.back().id;
+        freeCursor.store(static_cast<long long>(freeEntities.size()), std::memory_order_relaxed);
+    }
+
+    // Creates count entities with the prefab's components and appends their IDs
+    // to spawned. Free slots are reused first, then the scene grows in one step.
+    void Spawn(const Prefab &prefab, size_t count, std::vector<EntityID> &spawned) {
+        Spawn(prefab, nullptr, count, spawned);
     }
 
+    // Same, with entity i's body starting from bodies[i] instead of the
+    // prefab's. A TransformComponent in the prefab is set to each body's pose.
+    void Spawn(const Prefab &prefab, const RigidBodyState *bodies, size_t count, std::vector<EntityID> &spawned);
+
+    // False for destroyed entities and for handles from before a slot was recycled
+    bool IsAlive(EntityID id) const {
+        EntityIndex index = GetEntityIndex(id);
+        return index < entities.size() && entities[index].id == id;
+    }
+
+    // Null for handles that are not alive, so a stale one cannot reach a recycled slot
     template<typename T>
     T *Assign(EntityID id) {
+        if (!IsAlive(id)) {
+            return nullptr;
+        }
         int componentId = GetId<T>();
+        EntityIndex index = GetEntityIndex(id);
+        T* pComponent = &s_emptyComponent<T>;
 
-        if (componentPools.size() <= componentId) {
-            // Not enough component pool 
-            componentPools.resize(componentId + 1, nullptr);
-        }
-        
-        if (componentPools[componentId] == nullptr) {
-            // New component, create new pool
-            componentPools[componentId] = new ComponentPool(sizeof(T));
-        }
+        if constexpr (!std::is_empty_v<T>) {
+            TypedComponentPool<T> *pool = GetOrCreatePool<T>();
+            if (entities[index].mask.test(componentId)) {
+                // Reassigning replaces the old component
+                DestroyComponent(componentId, index);
+            }
+            pComponent = pool->construct(index);
+            pool->setChangeTick(index, currentTick);
 
-        // Looks up the component in the pool, and initializes it with placement new
-        T* pComponent = new (componentPools[componentId]->get(GetEntityIndex(id))) T();
+            if constexpr (std::is_same_v<T, RigidBodyComponent>) {
+                pComponent->body = rigidBodies.add(id);
+            }
+        }
 
         // Set the bit for the component to true
-        entities[GetEntityIndex(id)].mask.set(componentId);
+        SetMask(index, ComponentMask(entities[index].mask).set(componentId));
         return pComponent;
     }
 
+    // Assign<RigidBodyComponent> with the new body seeded from state instead of zeroed
+    RigidBodyComponent *AssignRigidBody(EntityID id, const RigidBodyState &state) {
+        RigidBodyComponent *component = Assign<RigidBodyComponent>(id);
+        if (component != nullptr) {
+            rigidBodies.write(component->body, state);
+        }
+        return component;
+    }
+
+    // Null when the entity lacks T or the handle is not alive
     template<typename T>
     T* Get(EntityID id) {
         int componentId = GetId<T>();
-        if (!entities[GetEntityIndex(id)].mask.test(componentId)) {
+        if (!IsAlive(id) || !entities[GetEntityIndex(id)].mask.test(componentId)) {
             return nullptr;
         }
 
-        T* pComponent = static_cast<T*>(componentPools[componentId]->get(GetEntityIndex(id)));
-        return pComponent;
+        return &ComponentAt<T>(GetPool<T>(), GetEntityIndex(id));
+    }
+
+    template<typename T>
+    TypedComponentPool<T>* GetOrCreatePool() {
+        static_assert(!std::is_empty_v<T>, "Tag components have no pool");
+        int componentId = GetId<T>();
+        if (componentPools[componentId] == nullptr) {
+            // New component, create new pool
+            componentPools[componentId] = new TypedComponentPool<T>();
+        }
+        return static_cast<TypedComponentPool<T>*>(componentPools[componentId]);
+    }
+
+    // Records that T was written for this entity during the current tick
+    template<typename T>
+    void MarkChanged(EntityID id) {
+        static_assert(!std::is_empty_v<T>, "Tag components carry no data to track");
+        componentPools[GetId<T>()]->setChangeTick(GetEntityIndex(id), currentTick);
+    }
+
+    // Starts a new tick and returns the one that just ended. Writes made from
+    // now on compare newer than the returned value in SceneView::eachChangedSince.
+    ChangeTick AdvanceTick() {
+        return currentTick++;
+    }
+
+    // Pool storing T, nullptr for tags or types never assigned
+    template<typename T>
+    ComponentPool* GetPool() const {
+        return componentPools[GetId<T>()];
+    }
+
+    // Component of the entity at index, which must have it. pool comes from GetPool<T>()
+    template<typename T>
+    static T& ComponentAt(ComponentPool *pool, EntityIndex index) {
+        if constexpr (std::is_empty_v<T>) {
+            return s_emptyComponent<T>;
+        } else {
+            return *static_cast<T*>(pool->get(index));
+        }
     }
 
     template<typename T>
@@ -94,15 +236,129 @@ struct Scene {
         }
 
         int componentId = GetId<T>();
-        entities[GetEntityIndex(id)].mask.reset(componentId);
+        if (!entities[GetEntityIndex(id)].mask.test(componentId)) {
+            return;
+        }
+
+        if constexpr (!std::is_empty_v<T>) {
+            DestroyComponent(componentId, GetEntityIndex(id));
+        }
+        SetMask(GetEntityIndex(id), ComponentMask(entities[GetEntityIndex(id)].mask).reset(componentId));
     }
 
     void DestroyEntity(EntityID id) {
+        // Reserved slots must be settled before the free list changes
+        FlushReservedEntities();
+        if (!IsAlive(id)) {
+            return;
+        }
+
         EntityID emptyID = CreateEntityId(EntityIndex(-1), GetEntityVersion(id) + 1);
+        ComponentMask oldMask = entities[GetEntityIndex(id)].mask;
+        DestroyComponents(GetEntityIndex(id), oldMask);
         entities[GetEntityIndex(id)].id = emptyID;
         entities[GetEntityIndex(id)].mask.reset();
+        UpdateViewCaches(GetEntityIndex(id), oldMask, true, ComponentMask(), false);
+        if (!freeEntities.empty() && freeEntities.back() < GetEntityIndex(id)) {
+            freeEntitiesSorted = false;
+        }
         freeEntities.push_back(GetEntityIndex(id));
+        freeCursor.store(static_cast<long long>(freeEntities.size()), std::memory_order_relaxed);
+    }
+
+    // Moves up to maxMoves live entities from the end of the scene into the
+    // lowest free slots, so live components gather in a dense prefix of the
+    // pools. Pages past the last live entity are released. Meant to run a
+    // little every frame; returns the number of entities moved, 0 once dense.
+    // Moved entities get a new ID, look old handles up with Resolve.
+    size_t Compact(size_t maxMoves);
+
+    // Renumbers the entities that own a rigid body so their index order follows
+    // the Z-order curve of the body positions, and sorts the body arrays the
+    // same way. Bodies close in space then sit close in every pool. Moved
+    // entities get a new ID, look old handles up with Resolve. Returns the
+    // number of entities moved.
+    size_t SortSpatially();
+
+    // Relocates the live entity at from into the free slot to, leaving from dead
+    void MoveEntity(EntityIndex from, EntityIndex to);
+
+    // Current ID of an entity whose handle may predate a Compact or SortSpatially
+    EntityID Resolve(EntityID id) const {
+        auto it = remappedEntities.find(id);
+        while (it != remappedEntities.end()) {
+            id = it->second;
+            it = remappedEntities.find(id);
+        }
+        return id;
+    }
+
+    // Forget old handles once every holder has resolved them
+    void ClearRemapTable() {
+        remappedEntities.clear();
+    }
+
+    // Runs the destructor of every pooled component in mask for the entity at index
+    void DestroyComponents(EntityIndex index, ComponentMask mask) {
+        for (int componentId = 0; componentId < COMPONENT_COUNT; componentId++) {
+            if (mask.test(componentId) && componentPools[componentId] != nullptr) {
+                DestroyComponent(componentId, index);
+            }
+        }
+    }
+
+    void DestroyComponent(int componentId, EntityIndex index) {
+        if (componentId == GetId<RigidBodyComponent>()) {
+            // Keep the body arrays packed, the body moved into the hole needs its new slot
+            uint32_t body = static_cast<RigidBodyComponent*>(componentPools[componentId]->get(index))->body;
+            EntityID moved = rigidBodies.remove(body);
+            if (moved != EntityID(-1)) {
+                static_cast<RigidBodyComponent*>(componentPools[componentId]->get(GetEntityIndex(moved)))->body = body;
+            }
+        }
+        componentPools[componentId]->destroy(index);
     }
+
+    // Destroys every entity and forgets all IDs. Pool pages and view caches are kept for reuse
+    void Clear();
+
+    // Cache of the entities matching mask, built on first use and kept in sync afterwards
+    ViewCache* GetViewCache(ComponentMask mask);
+
+    // Refills every view cache from the entity table, after it was written in bulk
+    void RefreshViewCaches();
+
+    // Replace the mask of a live entity and keep every view cache in sync
+    void SetMask(EntityIndex index, ComponentMask mask) {
+        ComponentMask oldMask = entities[index].mask;
+        entities[index].mask = mask;
+        UpdateViewCaches(index, oldMask, true, mask, true);
+    }
+
+    void UpdateViewCaches(EntityIndex index, ComponentMask oldMask, bool wasAlive, ComponentMask newMask, bool isAlive) {
+        for (ViewCache *cache : viewCaches) {
+            bool before = cache->Matches(oldMask, wasAlive);
+            bool after = cache->Matches(newMask, isAlive);
+            if (before == after) {
+                continue;
+            }
+            if (after) {
+                cache->Add(index);
+            } else {
+                cache->Remove(index);
+            }
+        }
+    }
+
+    // Memory held by one component type, zero if it was never assigned
+    template<typename T>
+    size_t GetMemoryUsage() const {
+        ComponentPool *pool = GetPool<T>();
+        return pool == nullptr ? 0 : pool->memoryUsage();
+    }
+
+    // Memory held by every component pool, one entry per component type
+    std::vector<PoolMemoryInfo> GetMemoryUsage() const;
 };
 
 
@@ -0,0 +1,429 @@
+#include "SceneSnapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "components/Components.h"
+
+static constexpr char SNAPSHOT_MAGIC[4] = { '2', 'D', 'S', 'S' };
+static constexpr uint32_t SNAPSHOT_VERSION = 7;
+// Every section starts on this boundary so blobs can be copied straight from the mapping
+static constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t componentCount;
+    uint32_t reserved;
+    uint64_t entityCount;
+    uint64_t freeCount;
+    uint64_t entitiesOffset;
+    uint64_t freeOffset;
+    uint64_t poolsOffset;
+    uint64_t bodyCount;
+    // Every RigidBodies array back to back, each bodyCount long and section aligned, then the owners
+    // and the sleep islands
+    uint64_t bodiesOffset;
+};
+
+struct SnapshotEntity {
+    uint64_t id;
+    uint64_t mask;
+};
+
+struct SnapshotPool {
+    uint32_t componentId;
+    uint32_t recordSize;
+    // Records cover entity indices [0, count), slots without the component are zeroed
+    uint64_t count;
+    uint64_t offset;
+};
+
+// Loaded records are raw bytes, components with a bounded size check them here
+template<typename T>
+static bool validRecord(const T &) {
+    return true;
+}
+
+static bool validRecord(const BoxComponent &box) {
+    return box.vertices.size() == BOX_VERTICES;
+}
+
+static bool validRecord(const PolygonComponent &polygon) {
+    return polygon.vertices.size() <= ShapeVertices::capacity();
+}
+
+static bool validRecord(const WorldShapeComponent &shape) {
+    return shape.vertices.size() <= ShapeVertices::capacity() && shape.normals.size() <= ShapeVertices::capacity();
+}
+
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+// Owners follow the last body array, relative to the start of the body section
+static uint64_t ownersOffset(uint64_t bodyCount) {
+    uint64_t size = 0;
+    RigidBodies().forEachArray([&](const BodyArray &) {
+        size = alignSection(size) + bodyCount * sizeof(float);
+    });
+    return alignSection(size);
+}
+
+// Sleep islands follow the owners
+static uint64_t sleepIslandsOffset(uint64_t bodyCount) {
+    return alignSection(ownersOffset(bodyCount) + bodyCount * sizeof(EntityID));
+}
+
+static uint64_t bodySectionSize(uint64_t bodyCount) {
+    return sleepIslandsOffset(bodyCount) + bodyCount * sizeof(uint32_t);
+}
+
+// Bytes each body adds to the body section, padding aside
+static uint64_t bodyRecordSize() {
+    uint64_t size = sizeof(EntityID) + sizeof(uint32_t);
+    RigidBodies().forEachArray([&](const BodyArray &) {
+        size += sizeof(float);
+    });
+    return size;
+}
+
+// Read-only view of a whole file, memory-mapped where the platform allows it
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (file) {
+            m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                m_data = static_cast<const char*>(mapping);
+                m_size = info.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (m_data != nullptr) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    bool contains(uint64_t offset, uint64_t bytes) const {
+        return offset <= m_size && bytes <= m_size - offset;
+    }
+
+    // Same for count elements of elementSize bytes, without multiplying them out first
+    bool contains(uint64_t offset, uint64_t count, uint64_t elementSize) const {
+        return offset <= m_size && count <= (m_size - offset) / elementSize;
+    }
+
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    std::vector<char> m_buffer;
+#endif
+};
+
+// Components are trivially copyable and stored as their own bytes, so pools move as raw pages
+template<typename T>
+static void writePool(const Scene &scene, std::vector<char> &out, SnapshotPool &entry) {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot components are stored as raw bytes");
+
+    size_t entityCount = scene.entities.size();
+    entry = { uint32_t(GetId<T>()), uint32_t(sizeof(T)), entityCount, alignSection(out.size()) };
+    out.resize(entry.offset + entityCount * sizeof(T), 0);
+
+    ComponentPool *pool = scene.GetPool<T>();
+    if (pool == nullptr) {
+        return;
+    }
+
+    // Whole pages at once, the mask tells which slots hold a component
+    char *records = out.data() + entry.offset;
+    for (size_t first = 0; first < entityCount; first += POOL_PAGE_ELEMENTS) {
+        if (pool->hasPage(first)) {
+            size_t count = std::min(POOL_PAGE_ELEMENTS, entityCount - first);
+            std::memcpy(records + first * sizeof(T), pool->get(first), count * sizeof(T));
+        }
+    }
+}
+
+template<typename T>
+static bool validatePool(const MappedFile &file, const SnapshotPool &entry, uint64_t entityCount) {
+    if (entry.componentId != GetId<T>() || entry.recordSize != sizeof(T) || entry.count != entityCount ||
+        !file.contains(entry.offset, entry.count, sizeof(T))) {
+        std::cerr << "Snapshot pool " << GetId<T>() << " does not match this build" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Entity IDs, free slots and body owners are indices into each other, a bad
+// one would reach outside the loaded arrays. Every live entity must sit at
+// its own index with only registered components, every free slot must be a
+// distinct dead entity, and rigid bodies and their entities must name each other.
+static bool validateEntities(const MappedFile &file, const SnapshotHeader &header, const SnapshotPool *pools) {
+    auto *entities = reinterpret_cast<const SnapshotEntity*>(file.data() + header.entitiesOffset);
+    auto *freeEntities = reinterpret_cast<const uint64_t*>(file.data() + header.freeOffset);
+    auto *bodies = reinterpret_cast<const RigidBodyComponent*>(file.data() + pools[GetId<RigidBodyComponent>()].offset);
+    uint64_t componentBits = COMPONENT_COUNT >= 64 ? ~uint64_t(0) : (uint64_t(1) << COMPONENT_COUNT) - 1;
+    uint64_t bodyBit = uint64_t(1) << GetId<RigidBodyComponent>();
+
+    uint64_t bodyOwners = 0;
+    for (uint64_t i = 0; i < header.entityCount; i++) {
+        const SnapshotEntity &entity = entities[i];
+        bool alive = isEntityValid(entity.id);
+        if ((entity.mask & ~componentBits) != 0 || (alive ? GetEntityIndex(entity.id) != i : entity.mask != 0)) {
+            std::cerr << "Snapshot entity " << i << " is inconsistent" << std::endl;
+            return false;
+        }
+        if ((entity.mask & bodyBit) != 0) {
+            uint32_t body = bodies[i].body;
+            if (body >= header.bodyCount) {
+                std::cerr << "Snapshot entity " << i << " has body " << body << " out of range" << std::endl;
+                return false;
+            }
+            bodyOwners++;
+        }
+    }
+
+    std::vector<bool> freed(header.entityCount, false);
+    for (uint64_t i = 0; i < header.freeCount; i++) {
+        uint64_t index = freeEntities[i];
+        if (index >= header.entityCount || isEntityValid(entities[index].id) || freed[index]) {
+            std::cerr << "Snapshot free slot " << index << " is not a distinct dead entity" << std::endl;
+            return false;
+        }
+        freed[index] = true;
+    }
+
+    // Each owner points back at its body, so with equal counts bodies and entities pair up one to one
+    auto *owners = reinterpret_cast<const EntityID*>(file.data() + header.bodiesOffset + ownersOffset(header.bodyCount));
+    for (uint64_t body = 0; body < header.bodyCount; body++) {
+        EntityID owner = owners[body];
+        uint64_t index = GetEntityIndex(owner);
+        if (!isEntityValid(owner) || index >= header.entityCount || entities[index].id != owner ||
+            (entities[index].mask & bodyBit) == 0 || bodies[index].body != body) {
+            std::cerr << "Snapshot body " << body << " has no matching owner" << std::endl;
+            return false;
+        }
+    }
+    if (bodyOwners != header.bodyCount) {
+        std::cerr << "Snapshot has " << bodyOwners << " rigid body entities for " << header.bodyCount << " bodies" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Every component named by the masks gets copied in, even a bad one, so a
+// failed load can still be cleared safely
+template<typename T>
+static bool readPool(Scene &scene, const MappedFile &file, const SnapshotPool &entry) {
+    bool ok = true;
+    const char *records = file.data() + entry.offset;
+    TypedComponentPool<T> *pool = nullptr;
+
+    for (EntityIndex i = 0; i < entry.count; i++) {
+        if (!scene.entities[i].mask.test(GetId<T>())) {
+            continue;
+        }
+        if (pool == nullptr) {
+            pool = scene.GetOrCreatePool<T>();
+        }
+
+        // Copy the rest of this page in one go and skip to the next one
+        size_t count = std::min<size_t>(POOL_PAGE_ELEMENTS - (i & POOL_PAGE_MASK), entry.count - i);
+        T *components = static_cast<T*>(pool->ensure(i));
+        std::memcpy(components, records + size_t(i) * sizeof(T), count * sizeof(T));
+        for (size_t j = 0; j < count; j++) {
+            pool->setChangeTick(i + j, scene.currentTick);
+            if (scene.entities[i + j].mask.test(GetId<T>()) && !validRecord(components[j])) {
+                ok = false;
+            }
+        }
+        i += EntityIndex(count - 1);
+    }
+
+    if (!ok) {
+        std::cerr << "Snapshot component " << GetId<T>() << " out of bounds" << std::endl;
+    }
+    return ok;
+}
+
+bool SceneSnapshot::save(const Scene &scene, const std::string &path) {
+    std::vector<char> out(sizeof(SnapshotHeader));
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.componentCount = COMPONENT_COUNT;
+    header.entityCount = scene.entities.size();
+    header.freeCount = scene.freeEntities.size();
+
+    header.entitiesOffset = alignSection(out.size());
+    out.resize(header.entitiesOffset + header.entityCount * sizeof(SnapshotEntity));
+    auto *entities = reinterpret_cast<SnapshotEntity*>(out.data() + header.entitiesOffset);
+    for (size_t i = 0; i < scene.entities.size(); i++) {
+        entities[i] = { scene.entities[i].id, scene.entities[i].mask.to_ullong() };
+    }
+
+    header.freeOffset = alignSection(out.size());
+    out.resize(header.freeOffset + header.freeCount * sizeof(uint64_t));
+    std::memcpy(out.data() + header.freeOffset, scene.freeEntities.data(), header.freeCount * sizeof(uint64_t));
+
+    // Directory first, then the blobs it points to
+    header.poolsOffset = alignSection(out.size());
+    out.resize(header.poolsOffset + COMPONENT_COUNT * sizeof(SnapshotPool));
+    std::vector<SnapshotPool> pools(COMPONENT_COUNT);
+    ForEachComponentType(RegisteredComponents{}, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        SnapshotPool &entry = pools[GetId<T>()];
+        if constexpr (std::is_empty_v<T>) {
+            // Tags only live in the masks
+            entry = { uint32_t(GetId<T>()), 0, 0, 0 };
+        } else {
+            writePool<T>(scene, out, entry);
+        }
+    });
+    std::memcpy(out.data() + header.poolsOffset, pools.data(), pools.size() * sizeof(SnapshotPool));
+
+    header.bodyCount = scene.rigidBodies.size();
+    header.bodiesOffset = alignSection(out.size());
+    out.resize(header.bodiesOffset);
+    scene.rigidBodies.forEachArray([&](const BodyArray &array) {
+        size_t offset = alignSection(out.size());
+        out.resize(offset + array.size() * sizeof(float));
+        std::memcpy(out.data() + offset, array.data(), array.size() * sizeof(float));
+    });
+    size_t ownersOffset = alignSection(out.size());
+    out.resize(ownersOffset + header.bodyCount * sizeof(EntityID));
+    std::memcpy(out.data() + ownersOffset, scene.rigidBodies.owners.data(), header.bodyCount * sizeof(EntityID));
+    size_t islandsOffset = alignSection(out.size());
+    out.resize(islandsOffset + header.bodyCount * sizeof(uint32_t));
+    std::memcpy(out.data() + islandsOffset, scene.rigidBodies.sleepIsland.data(), header.bodyCount * sizeof(uint32_t));
+
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+        std::cerr << "Failed to write snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SceneSnapshot::load(Scene &scene, const std::string &path) {
+    MappedFile file(path);
+    if (file.data() == nullptr || !file.contains(0, sizeof(SnapshotHeader))) {
+        std::cerr << "Failed to read snapshot: " << path << std::endl;
+        return false;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.componentCount != COMPONENT_COUNT) {
+        std::cerr << "Unsupported snapshot: " << path << std::endl;
+        return false;
+    }
+    // Counts are bounded by the file size before any of them is multiplied out
+    if (!file.contains(header.entitiesOffset, header.entityCount, sizeof(SnapshotEntity)) ||
+        !file.contains(header.freeOffset, header.freeCount, sizeof(uint64_t)) ||
+        !file.contains(header.poolsOffset, COMPONENT_COUNT, sizeof(SnapshotPool)) ||
+        header.bodyCount > file.size() / bodyRecordSize() ||
+        !file.contains(header.bodiesOffset, bodySectionSize(header.bodyCount))) {
+        std::cerr << "Truncated snapshot: " << path << std::endl;
+        return false;
+    }
+
+    auto *pools = reinterpret_cast<const SnapshotPool*>(file.data() + header.poolsOffset);
+    bool valid = true;
+    ForEachComponentType(RegisteredComponents{}, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        if constexpr (!std::is_empty_v<T>) {
+            valid = valid && validatePool<T>(file, pools[GetId<T>()], header.entityCount);
+        }
+    });
+    if (!valid || !validateEntities(file, header, pools)) {
+        return false;
+    }
+
+    scene.Clear();
+
+    auto *entities = reinterpret_cast<const SnapshotEntity*>(file.data() + header.entitiesOffset);
+    scene.entities.resize(header.entityCount);
+    for (size_t i = 0; i < header.entityCount; i++) {
+        scene.entities[i] = { entities[i].id, ComponentMask(entities[i].mask) };
+    }
+
+    scene.freeEntities.resize(header.freeCount);
+    std::memcpy(scene.freeEntities.data(), file.data() + header.freeOffset, header.freeCount * sizeof(uint64_t));
+    scene.freeEntitiesSorted = false;
+    scene.freeCursor.store(static_cast<long long>(header.freeCount), std::memory_order_relaxed);
+
+    // Body arrays come straight from the mapping, one copy per array
+    size_t bodyOffset = header.bodiesOffset;
+    scene.rigidBodies.forEachArray([&](BodyArray &array) {
+        bodyOffset = alignSection(bodyOffset);
+        auto *values = reinterpret_cast<const float*>(file.data() + bodyOffset);
+        array.assign(values, values + header.bodyCount);
+        bodyOffset += header.bodyCount * sizeof(float);
+    });
+    auto *owners = reinterpret_cast<const EntityID*>(file.data() + header.bodiesOffset + ownersOffset(header.bodyCount));
+    scene.rigidBodies.owners.assign(owners, owners + header.bodyCount);
+    auto *islands = reinterpret_cast<const uint32_t*>(file.data() + header.bodiesOffset + sleepIslandsOffset(header.bodyCount));
+    scene.rigidBodies.sleepIsland.assign(islands, islands + header.bodyCount);
+    // Query tree leaves belong to the world that made them, the loaded bodies get new ones
+    scene.rigidBodies.treeProxies.assign(header.bodyCount, -1);
+
+    bool ok = true;
+    ForEachComponentType(RegisteredComponents{}, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        if constexpr (!std::is_empty_v<T>) {
+            ok = readPool<T>(scene, file, pools[GetId<T>()]) && ok;
+        }
+    });
+
+    if (!ok) {
+        scene.Clear();
+        return false;
+    }
+
+    scene.RefreshViewCaches();
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+#include "Scene.h"
+
+// Versioned binary image of a whole Scene: the entity table, the free list,
+// every component pool as one contiguous blob indexed by entity, and the
+// body arrays. Files are tied to the component layout of the build that
+// wrote them and are rejected otherwise.
+namespace SceneSnapshot {
+    // Writes the snapshot with a single write call
+    bool save(const Scene &scene, const std::string &path);
+    // Replaces the content of scene with the snapshot, mapping the file instead of parsing it
+    bool load(Scene &scene, const std::string &path);
+}
@@ -1,83 +1,148 @@
 #pragma once
 
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <utility>
+
 #include "Scene.h"
 
 template<typename... ComponentTypes>
 struct SceneView {
+    // An empty mask matches every live entity
+    static constexpr ComponentMask componentMask = MakeComponentMask<ComponentTypes...>();
+
     Scene *pScene { nullptr };
-    ComponentMask componentMask;
-    bool all { false };
-
-    SceneView() {
-        if (sizeof...(ComponentTypes) == 0) {
-            all = true;
-        } else {
-            // Unpack the template parameters into an initializer list
-            int componentIds[] = { 0, GetId<ComponentTypes>()... };
-            for (int i = 1; i < (sizeof...(ComponentTypes) + 1); i++) {
-                componentMask.set(componentIds[i]);
-            }
-        }
-    }
+    ViewCache *pCache { nullptr };
 
-    explicit SceneView(Scene *scene) : pScene(scene) {
-        if (sizeof...(ComponentTypes) == 0) {
-            all = true;
-        } else {
-            // Unpack the template parameters into an initializer list
-            int componentIds[] = { 0, GetId<ComponentTypes>()... };
-            for (int i = 1; i < (sizeof...(ComponentTypes) + 1); i++) {
-                componentMask.set(componentIds[i]);
-            }
-        }
+    SceneView() = default;
+
+    template<typename T>
+    static constexpr bool HasComponent() {
+        return (std::is_same_v<T, ComponentTypes> || ...);
     }
 
+    explicit SceneView(Scene *scene) : pScene(scene), pCache(scene->GetViewCache(componentMask)) {}
+
     struct Iterator {
-        EntityIndex index;
         Scene* pScene;
-        ComponentMask mask;
-        bool all { false };
+        const EntityIndex* pIndex;
 
-        Iterator(Scene* scene, EntityIndex index, ComponentMask mask, bool all) : pScene(scene), index(index), mask(mask), all(all) {}
+        Iterator(Scene* scene, const EntityIndex* index) : pScene(scene), pIndex(index) {}
 
         EntityID operator*() const {
             // give back the entityID we're currently at
-            return pScene->entities[index].id;
+            return pScene->entities[*pIndex].id;
         }
 
         bool operator==(const Iterator& other) const {
-            // Compare two iterators
-            return index == other.index || index == pScene->entities.size();
+            return pIndex == other.pIndex;
         }
 
         bool operator!=(const Iterator& other) const {
-            return index != other.index && index != pScene->entities.size();
+            return pIndex != other.pIndex;
         }
 
         Iterator& operator++() {
-            // Move the iterator forward
-            do {
-                index++;
-            } while (index < pScene->entities.size() && !ValidIndex()); 
+            // Every cached index already matches, just move forward
+            pIndex++;
             return *this;
         }
+    };
 
-        bool ValidIndex() {
-            return isEntityValid(pScene->entities[index].id) && (all || (mask & pScene->entities[index].mask) == mask);
+    // Calls fn(EntityID, ComponentTypes&...) or fn(ComponentTypes&...) for every
+    // matching entity. Pools are looked up once per call instead of per entity.
+    template<typename Fn>
+    void each(Fn&& fn) const {
+        if (pCache->indices.empty()) {
+            return;
         }
-    };
+        eachImpl(fn, std::index_sequence_for<ComponentTypes...>());
+    }
+
+    // Same as each, limited to the entities where any of ChangedTypes was
+    // assigned or marked changed after tick. Walks the pool pages in index
+    // order and skips the pages with no change after tick.
+    template<typename... ChangedTypes, typename Fn>
+    void eachChangedSince(ChangeTick tick, Fn&& fn) const {
+        static_assert(sizeof...(ChangedTypes) > 0, "List at least one component to check for changes");
+        static_assert((HasComponent<ChangedTypes>() && ...), "Changed components must be part of the view");
+        if (pCache->indices.empty()) {
+            return;
+        }
+
+        const ComponentPool* changedPools[] = { pScene->GetPool<ChangedTypes>()... };
+        eachChangedImpl(tick, changedPools, sizeof...(ChangedTypes), fn, std::index_sequence_for<ComponentTypes...>());
+    }
+
+    size_t size() const {
+        return pCache->indices.size();
+    }
 
     Iterator begin() const {
         // Give an iterator to the beginning of this view
-        int firstIndex = 0;
-        while (firstIndex < pScene->entities.size() && (componentMask != (componentMask & pScene->entities[firstIndex].mask) || !isEntityValid(pScene->entities[firstIndex].id))) {
-            firstIndex++;
-        }
-        return Iterator(pScene, firstIndex, componentMask, all);
+        return Iterator(pScene, pCache->indices.data());
     }
 
     Iterator end() const
     {
-        return Iterator(pScene, EntityIndex(pScene->entities.size()), componentMask, all);
+        return Iterator(pScene, pCache->indices.data() + pCache->indices.size());
+    }
+
+private:
+    template<typename Fn, size_t... I>
+    void eachImpl(Fn& fn, std::index_sequence<I...>) const {
+        // Every matching entity has all the components, so their pools exist (tags have none)
+        ComponentPool* pools[] = { nullptr, pScene->GetPool<ComponentTypes>()... };
+
+        for (EntityIndex index : pCache->indices) {
+            if constexpr (std::is_invocable_v<Fn&, EntityID, ComponentTypes&...>) {
+                fn(pScene->entities[index].id, Scene::ComponentAt<ComponentTypes>(pools[I + 1], index)...);
+            } else {
+                fn(Scene::ComponentAt<ComponentTypes>(pools[I + 1], index)...);
+            }
+        }
+    }
+
+    template<typename Fn, size_t... I>
+    void eachChangedImpl(ChangeTick tick, const ComponentPool *const *changedPools, size_t changedCount,
+                         Fn& fn, std::index_sequence<I...>) const {
+        ComponentPool* pools[] = { nullptr, pScene->GetPool<ComponentTypes>()... };
+        const std::vector<Scene::EntityDesc> &entities = pScene->entities;
+
+        size_t pageCount = 0;
+        for (size_t i = 0; i < changedCount; i++) {
+            pageCount = std::max(pageCount, changedPools[i]->pageTicks.size());
+        }
+
+        for (size_t page = 0; page < pageCount; page++) {
+            bool pageChanged = false;
+            for (size_t i = 0; i < changedCount && !pageChanged; i++) {
+                pageChanged = changedPools[i]->pageChangeTick(page) > tick;
+            }
+            if (!pageChanged) {
+                continue;
+            }
+
+            size_t end = std::min((page + 1) << POOL_PAGE_SHIFT, entities.size());
+            for (size_t index = page << POOL_PAGE_SHIFT; index < end; index++) {
+                if (!pCache->Matches(entities[index].mask, isEntityValid(entities[index].id))) {
+                    continue;
+                }
+                // A matching entity has every changed component, so their pages exist
+                bool changed = false;
+                for (size_t i = 0; i < changedCount && !changed; i++) {
+                    changed = changedPools[i]->changeTick(index) > tick;
+                }
+                if (!changed) {
+                    continue;
+                }
+                if constexpr (std::is_invocable_v<Fn&, EntityID, ComponentTypes&...>) {
+                    fn(entities[index].id, Scene::ComponentAt<ComponentTypes>(pools[I + 1], index)...);
+                } else {
+                    fn(Scene::ComponentAt<ComponentTypes>(pools[I + 1], index)...);
+                }
+            }
+        }
     }
 };
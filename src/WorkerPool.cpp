@@ -0,0 +1,97 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define WORKER_POOL_PAUSE() _mm_pause()
+#else
+#define WORKER_POOL_PAUSE() std::this_thread::yield()
+#endif
+
+// Polls before a waiting thread starts yielding its core, then before a worker goes to sleep.
+// Short enough that a pool with more threads than free cores still makes progress
+static constexpr int SPIN_COUNT = 1 << 10;
+static constexpr int YIELD_COUNT = 1 << 10;
+
+// Pauses a polling loop, gently at first and then by giving the core away
+static void backOff(int &polls) {
+    if (polls < SPIN_COUNT) {
+        WORKER_POOL_PAUSE();
+    } else {
+        std::this_thread::yield();
+    }
+    polls++;
+}
+
+WorkerPool::WorkerPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_threads.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; i++) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop.store(true, std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t count, size_t grain) {
+    m_count = count;
+    m_grain = grain;
+    m_nextChunk.store(0, std::memory_order_relaxed);
+    m_running.store(static_cast<unsigned int>(m_threads.size()), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+    m_wake.notify_all();
+
+    runChunks();
+    // Every worker has to leave the loop before the next one may overwrite it
+    for (int polls = 0; m_running.load(std::memory_order_acquire) != 0;) {
+        backOff(polls);
+    }
+}
+
+void WorkerPool::runChunks() {
+    size_t chunkCount = (m_count + m_grain - 1) / m_grain;
+    for (size_t chunk = m_nextChunk.fetch_add(1, std::memory_order_relaxed); chunk < chunkCount;
+        chunk = m_nextChunk.fetch_add(1, std::memory_order_relaxed)) {
+        size_t begin = chunk * m_grain;
+        m_invoke(m_context, begin, std::min(begin + m_grain, m_count));
+    }
+}
+
+void WorkerPool::workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        uint64_t generation = m_generation.load(std::memory_order_acquire);
+        for (int polls = 0; generation == seen && polls < SPIN_COUNT + YIELD_COUNT;) {
+            backOff(polls);
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+        if (generation == seen) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_generation.load(std::memory_order_acquire) != seen; });
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+        seen = generation;
+        if (m_stop.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        runChunks();
+        m_running.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads for fork-join loops inside a step. The calling thread
+// works on every loop too, so a pool of threadCount threads starts
+// threadCount - 1 workers. Between loops workers spin for a short while and
+// then sleep, so back to back loops do not pay for a wake up each.
+class WorkerPool {
+public:
+    // 0 uses every core
+    explicit WorkerPool(unsigned int threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned int threadCount() const {
+        return static_cast<unsigned int>(m_threads.size() + 1);
+    }
+
+    // Calls fn(begin, end) on chunks of at most grain items covering [0, count)
+    // and returns once every chunk is done. Chunks go to whichever thread is
+    // free, so fn must give the same result whatever thread runs a chunk.
+    // Not reentrant, only one thread may call it at a time.
+    template<typename Fn>
+    void parallelFor(size_t count, size_t grain, const Fn &fn) {
+        if (m_threads.empty() || count <= grain) {
+            if (count > 0) {
+                fn(size_t(0), count);
+            }
+            return;
+        }
+        m_invoke = [](const void *context, size_t begin, size_t end) {
+            (*static_cast<const Fn*>(context))(begin, end);
+        };
+        m_context = &fn;
+        run(count, grain);
+    }
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    // Bumped for every loop, workers wait for it to change
+    std::atomic<uint64_t> m_generation{ 0 };
+    std::atomic<bool> m_stop{ false };
+    // Workers still inside the current loop
+    std::atomic<unsigned int> m_running{ 0 };
+
+    // Current loop, written before the generation is bumped
+    void (*m_invoke)(const void*, size_t, size_t) = nullptr;
+    const void *m_context = nullptr;
+    size_t m_count = 0;
+    size_t m_grain = 1;
+    std::atomic<size_t> m_nextChunk{ 0 };
+
+    void run(size_t count, size_t grain);
+    void runChunks();
+    void workerLoop();
+};
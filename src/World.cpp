@@ -0,0 +1,824 @@
+#include "World.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "Prefab.h"
+#include "SceneView.h"
+#include "SceneSnapshot.h"
+#include "utils.h"
+#include "components/Components.h"
+#include "physics/Transformations.h"
+
+// Entities moved per frame by the incremental compaction pass
+static constexpr size_t COMPACTION_MOVES_PER_STEP = 64;
+// Steps between two spatial sorts of the bodies, 0 turns sorting off
+static constexpr unsigned int SPATIAL_SORT_INTERVAL = 120;
+// Passes of the contact solver over every contact per step
+static constexpr int VELOCITY_ITERATIONS = 8;
+// Passes of the position correction after it
+static constexpr int POSITION_ITERATIONS = 4;
+// Below these speeds a body counts as resting
+static constexpr float LINEAR_SLEEP_TOLERANCE = 0.01f;
+static constexpr float ANGULAR_SLEEP_TOLERANCE = 0.035f;
+// Seconds every body of an island has to rest before the island sleeps
+static constexpr float TIME_TO_SLEEP = 0.5f;
+
+// Current world-space shape of a body, read from the body arrays so it is
+// right between steps as well. Circles leave polygon empty.
+struct BodyOutline {
+    glm::vec2 center;
+    float radius = 0.0f;
+    std::vector<glm::vec2> polygon;
+};
+
+static void boxOutline(const ShapeVertices &localVertices, float x, float y, float angle, std::vector<glm::vec2> &polygon) {
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    polygon.clear();
+    for (const glm::vec3 &vertex : localVertices) {
+        polygon.emplace_back(c * vertex.x - s * vertex.y + x, s * vertex.x + c * vertex.y + y);
+    }
+}
+
+static AABB outlineBounds(const BodyOutline &outline) {
+    if (outline.polygon.empty()) {
+        return { outline.center.x - outline.radius, outline.center.y - outline.radius,
+            outline.center.x + outline.radius, outline.center.y + outline.radius };
+    }
+    AABB bounds{ outline.polygon[0].x, outline.polygon[0].y, outline.polygon[0].x, outline.polygon[0].y };
+    for (const glm::vec2 &vertex : outline.polygon) {
+        bounds.minX = std::min(bounds.minX, vertex.x);
+        bounds.minY = std::min(bounds.minY, vertex.y);
+        bounds.maxX = std::max(bounds.maxX, vertex.x);
+        bounds.maxY = std::max(bounds.maxY, vertex.y);
+    }
+    return bounds;
+}
+
+// False when the entity is gone or has no body with a shape
+static bool readOutline(Scene &scene, EntityID entity, BodyOutline &outline) {
+    RigidBodyComponent *rigidBody = scene.Get<RigidBodyComponent>(entity);
+    if (rigidBody == nullptr) {
+        return false;
+    }
+    const RigidBodies &bodies = scene.rigidBodies;
+    uint32_t body = rigidBody->body;
+    outline.center = glm::vec2(bodies.x[body], bodies.y[body]);
+    outline.polygon.clear();
+    if (CircleComponent *circle = scene.Get<CircleComponent>(entity)) {
+        outline.radius = circle->radius;
+        return true;
+    }
+    if (BoxComponent *box = scene.Get<BoxComponent>(entity)) {
+        boxOutline(box->vertices, bodies.x[body], bodies.y[body], bodies.angle[body], outline.polygon);
+        return true;
+    }
+    return false;
+}
+
+// Twice the signed area, positive for counter clockwise polygons
+static float windingSign(const std::vector<glm::vec2> &polygon) {
+    float area = 0.0f;
+    for (size_t i = 0; i < polygon.size(); i++) {
+        area += Transformations::cross(polygon[i], polygon[(i + 1) % polygon.size()]);
+    }
+    return area < 0.0f ? -1.0f : 1.0f;
+}
+
+static bool outlineContains(const BodyOutline &outline, const glm::vec2 &point) {
+    if (outline.polygon.empty()) {
+        glm::vec2 offset = point - outline.center;
+        return glm::dot(offset, offset) <= outline.radius * outline.radius;
+    }
+    // Inside a convex polygon the point is on the inner side of every edge
+    float winding = windingSign(outline.polygon);
+    for (size_t i = 0; i < outline.polygon.size(); i++) {
+        const glm::vec2 &a = outline.polygon[i];
+        const glm::vec2 &b = outline.polygon[(i + 1) % outline.polygon.size()];
+        if (winding * Transformations::cross(b - a, point - a) < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool outlineOverlaps(const BodyOutline &outline, const AABB &region) {
+    if (outline.polygon.empty()) {
+        glm::vec2 closest(std::clamp(outline.center.x, region.minX, region.maxX), std::clamp(outline.center.y, region.minY, region.maxY));
+        glm::vec2 offset = closest - outline.center;
+        return glm::dot(offset, offset) <= outline.radius * outline.radius;
+    }
+    // Separating axes: the rectangle sides are covered by the bounds test, then every polygon edge
+    if (!outlineBounds(outline).overlaps(region)) {
+        return false;
+    }
+    const glm::vec2 corners[4] = { { region.minX, region.minY }, { region.maxX, region.minY },
+        { region.maxX, region.maxY }, { region.minX, region.maxY } };
+    for (size_t i = 0; i < outline.polygon.size(); i++) {
+        glm::vec2 edge = outline.polygon[(i + 1) % outline.polygon.size()] - outline.polygon[i];
+        glm::vec2 axis(-edge.y, edge.x);
+        float polygonMin = std::numeric_limits<float>::max(), polygonMax = std::numeric_limits<float>::lowest();
+        for (const glm::vec2 &vertex : outline.polygon) {
+            polygonMin = std::min(polygonMin, glm::dot(axis, vertex));
+            polygonMax = std::max(polygonMax, glm::dot(axis, vertex));
+        }
+        float regionMin = std::numeric_limits<float>::max(), regionMax = std::numeric_limits<float>::lowest();
+        for (const glm::vec2 &corner : corners) {
+            regionMin = std::min(regionMin, glm::dot(axis, corner));
+            regionMax = std::max(regionMax, glm::dot(axis, corner));
+        }
+        if (polygonMax < regionMin || regionMax < polygonMin) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Distance along the unit direction to the first point of the outline, negative on a miss
+static float outlineRaycast(const BodyOutline &outline, const glm::vec2 &origin, const glm::vec2 &direction) {
+    if (outline.polygon.empty()) {
+        glm::vec2 offset = origin - outline.center;
+        float b = glm::dot(offset, direction);
+        float c = glm::dot(offset, offset) - outline.radius * outline.radius;
+        if (c <= 0.0f) {
+            return 0.0f;
+        }
+        float discriminant = b * b - c;
+        if (b > 0.0f || discriminant < 0.0f) {
+            return -1.0f;
+        }
+        return -b - std::sqrt(discriminant);
+    }
+
+    // Clips the ray against the inner side of every edge
+    float winding = windingSign(outline.polygon);
+    float lower = 0.0f;
+    float upper = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < outline.polygon.size(); i++) {
+        const glm::vec2 &a = outline.polygon[i];
+        glm::vec2 edge = outline.polygon[(i + 1) % outline.polygon.size()] - a;
+        glm::vec2 normal = winding * glm::vec2(edge.y, -edge.x);
+        float numerator = glm::dot(normal, a - origin);
+        float denominator = glm::dot(normal, direction);
+        if (denominator == 0.0f) {
+            if (numerator < 0.0f) {
+                return -1.0f;
+            }
+        } else if (denominator < 0.0f) {
+            lower = std::max(lower, numerator / denominator);
+        } else {
+            upper = std::min(upper, numerator / denominator);
+        }
+        if (upper < lower) {
+            return -1.0f;
+        }
+    }
+    return lower;
+}
+
+void World::step(float deltaTime) {
+    // Moves recorded by the previous step have been resolved by now
+    m_scene.ClearRemapTable();
+    reorganize();
+    simulate(deltaTime);
+}
+
+void World::reorganize() {
+    size_t knownMoves = m_scene.remappedEntities.size();
+    m_scene.Compact(COMPACTION_MOVES_PER_STEP);
+    m_stepCount++;
+    if (SPATIAL_SORT_INTERVAL != 0 && m_stepCount % SPATIAL_SORT_INTERVAL == 0) {
+        m_scene.SortSpatially();
+    }
+    // Kept contacts refer to their bodies by owner, which moved entities changed
+    if (m_scene.remappedEntities.size() != knownMoves) {
+        m_solver.remapOwners([&](EntityID id) { return m_scene.Resolve(id); });
+    }
+}
+
+void World::simulate(float deltaTime) {
+    float damping = 0.8f;
+
+    RigidBodies &bodies = m_scene.rigidBodies;
+    size_t bodyCount = bodies.size();
+
+    // Bodies that are not moving keep their position, so their transform stays valid.
+    // Sleeping bodies have no velocity, one that got some from outside wakes its island
+    for (size_t i = 0; i < bodyCount; i++) {
+        if (bodies.vx[i] != 0.0f || bodies.vy[i] != 0.0f || bodies.omega[i] != 0.0f) {
+            if (bodies.sleepIsland[i] != 0) {
+                m_islandsToWake.push_back(bodies.sleepIsland[i]);
+            }
+            m_scene.MarkChanged<RigidBodyComponent>(bodies.owners[i]);
+        }
+    }
+    wakeIslands();
+
+    float dampingDelta = std::pow(damping, deltaTime);
+    float *__restrict x = bodies.x.data();
+    float *__restrict y = bodies.y.data();
+    float *__restrict vx = bodies.vx.data();
+    float *__restrict vy = bodies.vy.data();
+    float *__restrict angle = bodies.angle.data();
+    float *__restrict omega = bodies.omega.data();
+    const float *__restrict ax = bodies.ax.data();
+    const float *__restrict ay = bodies.ay.data();
+    const float *__restrict angularAcceleration = bodies.angularAcceleration.data();
+    const uint32_t *__restrict sleepIsland = bodies.sleepIsland.data();
+
+    // Straight passes over packed arrays, static bodies have no velocity or acceleration and stay put
+    for (size_t i = 0; i < bodyCount; i++) {
+        if (sleepIsland[i] != 0) {
+            continue;
+        }
+        x[i] += vx[i] * deltaTime;
+        y[i] += vy[i] * deltaTime;
+        angle[i] += omega[i] * deltaTime;
+        vx[i] = vx[i] * dampingDelta + ax[i] * deltaTime;
+        vy[i] = vy[i] * dampingDelta + ay[i] * deltaTime;
+        omega[i] = omega[i] * dampingDelta + angularAcceleration[i] * deltaTime;
+    }
+
+    // Shaped bodies made without the insert helpers get their cache the first time they are seen
+    SceneView<RigidBodyComponent, CircleComponent> circleView(&m_scene);
+    SceneView<RigidBodyComponent, BoxComponent> boxView(&m_scene);
+    SceneView<RigidBodyComponent, CircleComponent, WorldShapeComponent> cachedCircleView(&m_scene);
+    SceneView<RigidBodyComponent, BoxComponent, WorldShapeComponent> cachedBoxView(&m_scene);
+    if (cachedCircleView.size() != circleView.size() || cachedBoxView.size() != boxView.size()) {
+        std::vector<EntityID> uncached;
+        auto collect = [&](EntityID entity) {
+            if (m_scene.Get<WorldShapeComponent>(entity) == nullptr) {
+                uncached.push_back(entity);
+            }
+        };
+        for (EntityID entity : circleView) {
+            collect(entity);
+        }
+        for (EntityID entity : boxView) {
+            collect(entity);
+        }
+        for (EntityID entity : uncached) {
+            m_scene.Assign<WorldShapeComponent>(entity);
+        }
+    }
+
+    // Rebuild transforms and world shapes only for bodies moved since the last rebuild, by integration or by collision correction
+    SceneView<RigidBodyComponent, TransformComponent>(&m_scene).eachChangedSince<RigidBodyComponent>(m_transformTick,
+        [&](RigidBodyComponent &rigidBody, TransformComponent &transformComponent) {
+        glm::vec3 centerOfMass(bodies.x[rigidBody.body], bodies.y[rigidBody.body], 0.0f);
+        Transformations::updateMatrix(transformComponent.transformMatrix, centerOfMass, bodies.angle[rigidBody.body]);
+    });
+    SceneView<RigidBodyComponent, BoxComponent, TransformComponent, WorldShapeComponent>(&m_scene)
+        .eachChangedSince<RigidBodyComponent, BoxComponent, WorldShapeComponent>(m_transformTick,
+        [&](RigidBodyComponent &, BoxComponent &boxComponent, TransformComponent &transformComponent, WorldShapeComponent &shape) {
+        Transformations::computeWorldVertices(boxComponent.vertices, transformComponent.transformMatrix, shape.vertices);
+        Transformations::computeEdgeNormals(shape.vertices, shape.normals);
+        shape.boundsMin = glm::vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        shape.boundsMax = glm::vec2(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+        for (const glm::vec3 &vertex : shape.vertices) {
+            shape.boundsMin = glm::vec2(std::min(shape.boundsMin.x, vertex.x), std::min(shape.boundsMin.y, vertex.y));
+            shape.boundsMax = glm::vec2(std::max(shape.boundsMax.x, vertex.x), std::max(shape.boundsMax.y, vertex.y));
+        }
+    });
+    cachedCircleView.eachChangedSince<RigidBodyComponent, CircleComponent, WorldShapeComponent>(m_transformTick,
+        [&](RigidBodyComponent &rigidBody, CircleComponent &circleComponent, WorldShapeComponent &shape) {
+        float radius = circleComponent.radius;
+        shape.boundsMin = glm::vec2(bodies.x[rigidBody.body] - radius, bodies.y[rigidBody.body] - radius);
+        shape.boundsMax = glm::vec2(bodies.x[rigidBody.body] + radius, bodies.y[rigidBody.body] + radius);
+    });
+    m_transformTick = m_scene.AdvanceTick();
+
+    // Bounds and shape of every body, indexed by body slot. Bodies without a shape keep empty bounds
+    m_bounds.assign(bodyCount, AABB{ 1.0f, 1.0f, 0.0f, 0.0f });
+    m_shapes.assign(bodyCount, BodyShape());
+    cachedCircleView.each([&](RigidBodyComponent &rigidBody, CircleComponent &circleComponent, WorldShapeComponent &shape) {
+        m_bounds[rigidBody.body] = { shape.boundsMin.x, shape.boundsMin.y, shape.boundsMax.x, shape.boundsMax.y };
+        m_shapes[rigidBody.body].circle = &circleComponent;
+    });
+    cachedBoxView.each([&](RigidBodyComponent &rigidBody, BoxComponent &boxComponent, WorldShapeComponent &shape) {
+        m_bounds[rigidBody.body] = { shape.boundsMin.x, shape.boundsMin.y, shape.boundsMax.x, shape.boundsMax.y };
+        m_shapes[rigidBody.body].box = &boxComponent;
+        m_shapes[rigidBody.body].world = &shape;
+    });
+
+    // Only pairs with overlapping bounds and a moving body reach the narrowphase, each one once
+    m_active.resize(bodyCount);
+    for (size_t i = 0; i < bodyCount; i++) {
+        m_active[i] = !bodies.isStatic(static_cast<uint32_t>(i)) && bodies.sleepIsland[i] == 0;
+    }
+    m_broadphase.findPairs(m_bounds, m_active, m_pairs);
+
+    m_solver.beginStep();
+    for (const BodyPair &pair : m_pairs) {
+        uint32_t a = pair.a;
+        uint32_t b = pair.b;
+        // Two static bodies cannot push each other
+        if (bodies.isStatic(a) && bodies.isStatic(b)) {
+            continue;
+        }
+        // The circle goes first in a circle box test, otherwise the lower owner ID does so
+        // the solver sees the pair the same way round every step
+        bool sameShape = (m_shapes[a].circle != nullptr) == (m_shapes[b].circle != nullptr);
+        if ((m_shapes[a].box != nullptr && m_shapes[b].circle != nullptr) || (sameShape && bodies.owners[b] < bodies.owners[a])) {
+            std::swap(a, b);
+        }
+        const BodyShape &shapeA = m_shapes[a];
+        const BodyShape &shapeB = m_shapes[b];
+
+        glm::vec3 centerA(bodies.x[a], bodies.y[a], 0.0f);
+        glm::vec3 centerB(bodies.x[b], bodies.y[b], 0.0f);
+
+        Manifold m{};
+        bool colliding;
+        if (shapeA.circle != nullptr && shapeB.circle != nullptr) {
+            colliding = m.CirclevsCircle(centerA, shapeA.circle->radius, centerB, shapeB.circle->radius);
+        } else if (shapeA.circle != nullptr) {
+            colliding = m.CirclevsBox(centerA, shapeA.circle->radius, shapeB.world->vertices, shapeB.world->normals, centerB);
+        } else {
+            colliding = m.BoxvsBox(shapeA.world->vertices, shapeA.world->normals, centerA,
+                shapeB.world->vertices, shapeB.world->normals, centerB);
+        }
+
+        if (colliding) {
+            // A moving body ran into a sleeping one
+            if (bodies.sleepIsland[a] != 0 || bodies.sleepIsland[b] != 0) {
+                m_islandsToWake.push_back(std::max(bodies.sleepIsland[a], bodies.sleepIsland[b]));
+            }
+            m_solver.add(bodies, a, b, m);
+            m_scene.MarkChanged<RigidBodyComponent>(bodies.owners[a]);
+            m_scene.MarkChanged<RigidBodyComponent>(bodies.owners[b]);
+        }
+    }
+    wakeIslands();
+    m_solver.solve(bodies, VELOCITY_ITERATIONS, m_solverWorkers.get());
+    m_solver.solvePositions(bodies, POSITION_ITERATIONS, m_solverWorkers.get());
+
+    updateSleep(deltaTime);
+    updateTree(deltaTime);
+}
+
+// Tag after the given one. 0 means awake, so it is skipped when the tags wrap
+static uint32_t nextIslandTag(uint32_t tag) {
+    return tag == std::numeric_limits<uint32_t>::max() ? 1 : tag + 1;
+}
+
+// Union-find root of an island, halving the path on the way
+static uint32_t islandRoot(std::vector<uint32_t> &parents, uint32_t body) {
+    while (parents[body] != body) {
+        parents[body] = parents[parents[body]];
+        body = parents[body];
+    }
+    return body;
+}
+
+void World::updateSleep(float deltaTime) {
+    RigidBodies &bodies = m_scene.rigidBodies;
+    size_t bodyCount = bodies.size();
+    auto awakeDynamic = [&](size_t i) {
+        return !bodies.isStatic(static_cast<uint32_t>(i)) && bodies.sleepIsland[i] == 0;
+    };
+
+    for (size_t i = 0; i < bodyCount; i++) {
+        if (!awakeDynamic(i)) {
+            continue;
+        }
+        float speedSquared = bodies.vx[i] * bodies.vx[i] + bodies.vy[i] * bodies.vy[i];
+        if (speedSquared > LINEAR_SLEEP_TOLERANCE * LINEAR_SLEEP_TOLERANCE || std::abs(bodies.omega[i]) > ANGULAR_SLEEP_TOLERANCE) {
+            bodies.sleepTime[i] = 0.0f;
+        } else {
+            bodies.sleepTime[i] += deltaTime;
+        }
+    }
+
+    // Islands are the bodies linked by this step's contacts. Static bodies do
+    // not link, so everything resting on one floor is not one island
+    m_islandParents.resize(bodyCount);
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        m_islandParents[i] = i;
+    }
+    for (const ContactConstraint &constraint : m_solver.constraints()) {
+        if (!bodies.isStatic(constraint.bodyA) && !bodies.isStatic(constraint.bodyB)) {
+            m_islandParents[islandRoot(m_islandParents, constraint.bodyA)] = islandRoot(m_islandParents, constraint.bodyB);
+        }
+    }
+
+    // An island sleeps once its least rested body has rested long enough
+    m_islandSleepTimes.assign(bodyCount, std::numeric_limits<float>::max());
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        if (awakeDynamic(i)) {
+            float &islandTime = m_islandSleepTimes[islandRoot(m_islandParents, i)];
+            islandTime = std::min(islandTime, bodies.sleepTime[i]);
+        }
+    }
+    m_islandTags.assign(bodyCount, 0);
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        if (!awakeDynamic(i)) {
+            continue;
+        }
+        uint32_t root = islandRoot(m_islandParents, i);
+        if (m_islandSleepTimes[root] < TIME_TO_SLEEP) {
+            continue;
+        }
+        if (m_islandTags[root] == 0) {
+            m_islandTags[root] = m_nextIsland;
+            m_nextIsland = nextIslandTag(m_nextIsland);
+        }
+        bodies.sleepIsland[i] = m_islandTags[root];
+        bodies.vx[i] = 0.0f;
+        bodies.vy[i] = 0.0f;
+        bodies.omega[i] = 0.0f;
+    }
+}
+
+void World::wakeIslands() {
+    if (m_islandsToWake.empty()) {
+        return;
+    }
+    std::sort(m_islandsToWake.begin(), m_islandsToWake.end());
+    RigidBodies &bodies = m_scene.rigidBodies;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies.sleepIsland[i] != 0 && std::binary_search(m_islandsToWake.begin(), m_islandsToWake.end(), bodies.sleepIsland[i])) {
+            bodies.sleepIsland[i] = 0;
+            bodies.sleepTime[i] = 0.0f;
+        }
+    }
+    m_islandsToWake.clear();
+}
+
+void World::wake(EntityID entity) {
+    RigidBodyComponent *rigidBody = m_scene.Get<RigidBodyComponent>(entity);
+    if (rigidBody == nullptr) {
+        return;
+    }
+    RigidBodies &bodies = m_scene.rigidBodies;
+    if (bodies.sleepIsland[rigidBody->body] != 0) {
+        m_islandsToWake.push_back(bodies.sleepIsland[rigidBody->body]);
+        wakeIslands();
+    }
+    bodies.sleepTime[rigidBody->body] = 0.0f;
+}
+
+void World::setSolverThreads(unsigned int threadCount) {
+    m_solverWorkers.reset();
+    if (threadCount != 1) {
+        m_solverWorkers = std::make_unique<WorkerPool>(threadCount);
+    }
+}
+
+void World::setFixedStep(float stepSeconds, int substeps, int maxStepsPerFrame) {
+    // A zero, negative or non-finite step would never drain the accumulator
+    if (std::isfinite(stepSeconds) && stepSeconds > 0.0f) {
+        m_fixedStep = stepSeconds;
+    }
+    m_substeps = std::max(1, substeps);
+    m_maxStepsPerFrame = std::max(1, maxStepsPerFrame);
+}
+
+int World::advance(double frameSeconds) {
+    m_accumulator += std::max(frameSeconds, 0.0);
+    RigidBodies &bodies = m_scene.rigidBodies;
+    float substep = m_fixedStep / static_cast<float>(m_substeps);
+    // Moves of the previous frame have been resolved by now, the ones of this
+    // frame's steps pile up until the caller resolves its handles
+    m_scene.ClearRemapTable();
+
+    int steps = 0;
+    while (m_accumulator >= m_fixedStep && steps < m_maxStepsPerFrame) {
+        bodies.previousX = bodies.x;
+        bodies.previousY = bodies.y;
+        bodies.previousAngle = bodies.angle;
+        reorganize();
+        for (int i = 0; i < m_substeps; i++) {
+            simulate(substep);
+        }
+        m_accumulator -= m_fixedStep;
+        steps++;
+    }
+    // Time the cap left behind is dropped, only the part of a step is kept
+    if (m_accumulator >= m_fixedStep) {
+        m_accumulator = std::fmod(m_accumulator, static_cast<double>(m_fixedStep));
+    }
+    m_interpolationAlpha = static_cast<float>(m_accumulator / m_fixedStep);
+    return steps;
+}
+
+glm::mat4 World::drawTransform(EntityID entity, const glm::mat4 &transformMatrix) {
+    RigidBodyComponent *rigidBody = m_scene.Get<RigidBodyComponent>(entity);
+    if (rigidBody == nullptr || m_interpolationAlpha == 1.0f) {
+        return transformMatrix;
+    }
+
+    const RigidBodies &bodies = m_scene.rigidBodies;
+    uint32_t body = rigidBody->body;
+    float alpha = m_interpolationAlpha;
+    glm::vec3 position(bodies.previousX[body] * (1.0f - alpha) + bodies.x[body] * alpha,
+        bodies.previousY[body] * (1.0f - alpha) + bodies.y[body] * alpha, 0.0f);
+    glm::mat4 transform;
+    Transformations::updateMatrix(transform, position, bodies.previousAngle[body] * (1.0f - alpha) + bodies.angle[body] * alpha);
+    return transform;
+}
+
+bool World::isAwake(EntityID entity) {
+    RigidBodyComponent *rigidBody = m_scene.Get<RigidBodyComponent>(entity);
+    return rigidBody != nullptr && m_scene.rigidBodies.sleepIsland[rigidBody->body] == 0;
+}
+
+EntityID World::insertCircle(float centerX, float centerY, float radius, const glm::vec4 &color) {
+    EntityID circle = m_scene.NewEntity();
+
+    // Positional and physics components
+    auto rigidBodyComponent = m_scene.Assign<RigidBodyComponent>(circle);
+    auto circleComponent = m_scene.Assign<CircleComponent>(circle);
+    auto transformComponent = m_scene.Assign<TransformComponent>(circle);
+    m_scene.Assign<WorldShapeComponent>(circle);
+    m_scene.Assign<MovingComponent>(circle);
+
+    // Draw components
+    auto colorComponent = m_scene.Assign<ColorComponent>(circle);
+
+    RigidBodies &bodies = m_scene.rigidBodies;
+    uint32_t body = rigidBodyComponent->body;
+    bodies.x[body] = bodies.previousX[body] = centerX;
+    bodies.y[body] = bodies.previousY[body] = centerY;
+    bodies.invMass[body] = 1.0f / 8.0f;
+    bodies.ay[body] = -5.0f;
+    circleComponent->radius = radius;
+    bodies.invInertia[body] = 1 / (Transformations::calculateCircleInertia(1.0f / bodies.invMass[body], radius) * 10);
+
+    bodies.staticFriction[body] = 0.6f;
+    bodies.dynamicFriction[body] = 0.4f;
+    bodies.restitution[body] = 0.5f;
+
+    colorComponent->color = color;
+
+    Transformations::updateMatrix(transformComponent->transformMatrix, glm::vec3(centerX, centerY, 0.0f), bodies.angle[body]);
+    return circle;
+}
+
+std::vector<EntityID> World::insertCircles(const std::vector<glm::vec2> &centers, float radius, const glm::vec4 &color) {
+    Prefab prefab;
+    prefab.Set<RigidBodyComponent>();
+    prefab.Set<CircleComponent>().radius = radius;
+    prefab.Set<TransformComponent>();
+    prefab.Set<WorldShapeComponent>();
+    prefab.Set<MovingComponent>();
+    prefab.Set<ColorComponent>().color = color;
+
+    prefab.body.invMass = 1.0f / 8.0f;
+    prefab.body.ay = -5.0f;
+    prefab.body.invInertia = 1 / (Transformations::calculateCircleInertia(8.0f, radius) * 10);
+    prefab.body.staticFriction = 0.6f;
+    prefab.body.dynamicFriction = 0.4f;
+    prefab.body.restitution = 0.5f;
+
+    std::vector<RigidBodyState> bodies(centers.size(), prefab.body);
+    for (size_t i = 0; i < centers.size(); i++) {
+        bodies[i].x = centers[i].x;
+        bodies[i].y = centers[i].y;
+    }
+
+    std::vector<EntityID> circles;
+    m_scene.Spawn(prefab, bodies.data(), bodies.size(), circles);
+    return circles;
+}
+
+EntityID World::insertStaticBox(const glm::vec3& position, float width, float height, const glm::vec4 &color) {
+    EntityID box = m_scene.NewEntity();
+    auto boxComponent = m_scene.Assign<BoxComponent>(box);
+    auto rigidBodyComponent = m_scene.Assign<RigidBodyComponent>(box);
+    auto transformComponent = m_scene.Assign<TransformComponent>(box);
+    m_scene.Assign<WorldShapeComponent>(box);
+
+    // Draw components
+    auto colorComponent = m_scene.Assign<ColorComponent>(box);
+
+    std::vector<glm::vec3> boxVertices = createBoxVertices(width, height);
+    boxComponent->vertices.assign(boxVertices.begin(), boxVertices.end());
+
+    // Zero inverse mass and inertia, nothing can move it
+    RigidBodies &bodies = m_scene.rigidBodies;
+    uint32_t body = rigidBodyComponent->body;
+    bodies.x[body] = bodies.previousX[body] = position.x;
+    bodies.y[body] = bodies.previousY[body] = position.y;
+
+    bodies.staticFriction[body] = 0.6f;
+    bodies.dynamicFriction[body] = 0.4f;
+
+    colorComponent->color = color;
+
+    Transformations::updateMatrix(transformComponent->transformMatrix, position, bodies.angle[body]);
+    return box;
+}
+
+EntityID World::insertBox(const glm::vec3& position, float width, float height, const glm::vec4 &color) {
+    EntityID box = m_scene.NewEntity();
+    auto boxComponent = m_scene.Assign<BoxComponent>(box);
+    auto rigidBodyComponent = m_scene.Assign<RigidBodyComponent>(box);
+    auto transformComponent = m_scene.Assign<TransformComponent>(box);
+    m_scene.Assign<WorldShapeComponent>(box);
+
+    m_scene.Assign<MovingComponent>(box);
+
+    // Draw components
+    auto colorComponent = m_scene.Assign<ColorComponent>(box);
+
+    std::vector<glm::vec3> boxVertices = createBoxVertices(width, height);
+    boxComponent->vertices.assign(boxVertices.begin(), boxVertices.end());
+
+    RigidBodies &bodies = m_scene.rigidBodies;
+    uint32_t body = rigidBodyComponent->body;
+    bodies.invMass[body] = 1.0f / 10.0f;
+    bodies.x[body] = bodies.previousX[body] = position.x;
+    bodies.y[body] = bodies.previousY[body] = position.y;
+    bodies.ay[body] = -5.0f;
+
+    bodies.invInertia[body] = 1 / (Transformations::calculateBoxInertia(1.0f / bodies.invMass[body], width, height) * 10);
+    bodies.staticFriction[body] = 0.8f;
+    bodies.dynamicFriction[body] = 0.6f;
+    bodies.restitution[body] = 0.1f;
+
+    colorComponent->color = color;
+
+    Transformations::updateMatrix(transformComponent->transformMatrix, position, bodies.angle[body]);
+    return box;
+}
+
+void World::updateTree(float deltaTime) {
+    RigidBodies &bodies = m_scene.rigidBodies;
+    BodyOutline outline;
+    auto indexBody = [&](uint32_t body) {
+        int32_t &proxy = bodies.treeProxies[body];
+        const BodyShape &shape = m_shapes[body];
+        outline.center = glm::vec2(bodies.x[body], bodies.y[body]);
+        if (shape.circle != nullptr) {
+            outline.radius = shape.circle->radius;
+            outline.polygon.clear();
+        } else {
+            boxOutline(shape.box->vertices, bodies.x[body], bodies.y[body], bodies.angle[body], outline.polygon);
+        }
+        AABB bounds = outlineBounds(outline);
+
+        if (proxy == DynamicTree::NULL_NODE) {
+            proxy = m_tree.createProxy(bounds, bodies.owners[body]);
+        } else {
+            m_tree.moveProxy(proxy, bounds, glm::vec2(bodies.vx[body], bodies.vy[body]) * deltaTime);
+        }
+    };
+
+    // Only bodies written since the last update can have left their fat
+    // bounds. Integration, collision correction and new shapes all mark them
+    SceneView<RigidBodyComponent, CircleComponent, WorldShapeComponent> circleView(&m_scene);
+    SceneView<RigidBodyComponent, BoxComponent, WorldShapeComponent> boxView(&m_scene);
+    circleView.eachChangedSince<RigidBodyComponent, CircleComponent, WorldShapeComponent>(m_treeTick,
+        [&](RigidBodyComponent &rigidBody, CircleComponent &, WorldShapeComponent &) {
+        indexBody(rigidBody.body);
+    });
+    boxView.eachChangedSince<RigidBodyComponent, BoxComponent, WorldShapeComponent>(m_treeTick,
+        [&](RigidBodyComponent &rigidBody, BoxComponent &, WorldShapeComponent &) {
+        indexBody(rigidBody.body);
+    });
+    m_treeTick = m_scene.AdvanceTick();
+
+    // Compaction and spatial sorting give entities new IDs without writing them
+    for (const auto &[oldID, newID] : m_scene.remappedEntities) {
+        RigidBodyComponent *rigidBody = m_scene.Get<RigidBodyComponent>(newID);
+        if (rigidBody != nullptr && bodies.treeProxies[rigidBody->body] != DynamicTree::NULL_NODE) {
+            m_tree.setUserData(bodies.treeProxies[rigidBody->body], newID);
+        }
+    }
+
+    // Every shaped body has a leaf now. Extra leaves belong to destroyed
+    // bodies, which lost their slot and are the ones no body points back to,
+    // or to bodies that lost their shape
+    if (m_tree.proxyCount() > circleView.size() + boxView.size()) {
+        std::vector<int32_t> stale;
+        m_tree.forEachProxy([&](int32_t proxy) {
+            EntityID owner = m_tree.userData(proxy);
+            RigidBodyComponent *rigidBody = m_scene.Get<RigidBodyComponent>(owner);
+            if (rigidBody == nullptr || bodies.treeProxies[rigidBody->body] != proxy) {
+                stale.push_back(proxy);
+            } else if (m_shapes[rigidBody->body].circle == nullptr && m_shapes[rigidBody->body].box == nullptr) {
+                bodies.treeProxies[rigidBody->body] = DynamicTree::NULL_NODE;
+                stale.push_back(proxy);
+            }
+        });
+        // Whatever slept on a destroyed body wakes up, the bodies near its leaf
+        for (int32_t proxy : stale) {
+            m_tree.query(m_tree.fatBounds(proxy), [&](int32_t neighbor) {
+                EntityID owner = m_tree.userData(neighbor);
+                RigidBodyComponent *rigidBody = m_scene.Get<RigidBodyComponent>(owner);
+                if (rigidBody != nullptr && bodies.sleepIsland[rigidBody->body] != 0) {
+                    m_islandsToWake.push_back(bodies.sleepIsland[rigidBody->body]);
+                }
+            });
+        }
+        wakeIslands();
+        for (int32_t proxy : stale) {
+            m_tree.destroyProxy(proxy);
+        }
+    }
+}
+
+void World::queryPoint(const glm::vec2 &point, std::vector<EntityID> &hits) {
+    BodyOutline outline;
+    m_tree.query(AABB{ point.x, point.y, point.x, point.y }, [&](int32_t proxy) {
+        EntityID entity = m_tree.userData(proxy);
+        if (readOutline(m_scene, entity, outline) && outlineContains(outline, point)) {
+            hits.push_back(entity);
+        }
+    });
+}
+
+void World::queryAABB(const AABB &region, std::vector<EntityID> &hits) {
+    BodyOutline outline;
+    m_tree.query(region, [&](int32_t proxy) {
+        EntityID entity = m_tree.userData(proxy);
+        if (readOutline(m_scene, entity, outline) && outlineOverlaps(outline, region)) {
+            hits.push_back(entity);
+        }
+    });
+}
+
+bool World::raycast(const glm::vec2 &origin, const glm::vec2 &direction, float maxDistance, RaycastHit &hit) {
+    float length = glm::length(direction);
+    if (length == 0.0f) {
+        return false;
+    }
+    glm::vec2 unitDirection = direction / length;
+
+    bool found = false;
+    BodyOutline outline;
+    m_tree.raycast(origin, unitDirection, maxDistance, [&](int32_t proxy, float closest) {
+        EntityID entity = m_tree.userData(proxy);
+        if (!readOutline(m_scene, entity, outline)) {
+            return closest;
+        }
+        float distance = outlineRaycast(outline, origin, unitDirection);
+        if (distance < 0.0f || distance > closest) {
+            return closest;
+        }
+        found = true;
+        hit = { entity, distance, origin + unitDirection * distance };
+        return distance;
+    });
+    return found;
+}
+
+bool World::saveSnapshot(const std::string &path) const {
+    return SceneSnapshot::save(m_scene, path);
+}
+
+bool World::loadSnapshot(const std::string &path) {
+    if (!SceneSnapshot::load(m_scene, path)) {
+        return false;
+    }
+    m_transformTick = 0;
+    m_treeTick = 0;
+    m_tree.clear();
+    m_solver.clear();
+    m_islandsToWake.clear();
+    // New islands must not reuse the tags of the loaded sleeping ones
+    uint32_t lastIsland = 0;
+    for (uint32_t island : m_scene.rigidBodies.sleepIsland) {
+        lastIsland = std::max(lastIsland, island);
+    }
+    m_nextIsland = nextIslandTag(lastIsland);
+    return true;
+}
+
+void World::stepAll(const std::vector<World*> &worlds, float deltaTime, size_t stepCount,
+    const std::function<void(size_t, World&)> &onFinished, unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, worlds.size()));
+
+    // Threads pull whole worlds, so a slow world does not hold up a fixed share
+    std::atomic<size_t> nextWorld{ 0 };
+    auto worker = [&]() {
+        for (size_t i = nextWorld++; i < worlds.size(); i = nextWorld++) {
+            World &world = *worlds[i];
+            for (size_t step = 0; step < stepCount; step++) {
+                world.step(deltaTime);
+            }
+            if (onFinished) {
+                onFinished(i, world);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (unsigned int i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    // The calling thread takes its share too
+    worker();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
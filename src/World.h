@@ -0,0 +1,159 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+#include "physics/Broadphase.h"
+#include "physics/ContactSolver.h"
+#include "physics/DynamicTree.h"
+#include "WorkerPool.h"
+#include "glm/glm.hpp"
+
+struct RaycastHit {
+    EntityID entity;
+    float distance;
+    glm::vec2 point;
+};
+
+// One self-contained simulation: a Scene and the physics that steps it. A
+// world owns all of its storage and touches no GL or process-wide state, so
+// any number of them can live in one process and step on different threads.
+class World {
+public:
+    World() = default;
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    EntityID insertCircle(float centerX, float centerY, float radius, const glm::vec4 &color);
+    // Spawns one circle per center in a single batch, returns their IDs
+    std::vector<EntityID> insertCircles(const std::vector<glm::vec2> &centers, float radius, const glm::vec4 &color);
+    EntityID insertBox(const glm::vec3& position, float width, float height, const glm::vec4 &color);
+    EntityID insertStaticBox(const glm::vec3& position, float width, float height, const glm::vec4 &color);
+
+    // Advances the simulation by deltaTime. The step may move entities to new
+    // slots, handles kept across it are updated with scene().Resolve until the
+    // next step or advance begins
+    void step(float deltaTime);
+
+    // Bodies that stay nearly still for a while fall asleep with every body
+    // they touch, and are left out of integration and collision until a moving
+    // body hits them, their velocity is set from outside or a body under them
+    // is destroyed. Moving a sleeping body by hand needs a wake call.
+    void wake(EntityID entity);
+    bool isAwake(EntityID entity);
+
+    // Contacts are solved on threadCount threads, the stepping one included,
+    // 0 uses every core. 1, the default, keeps the whole step on the caller.
+    // The outcome of a step does not depend on the thread count. Worlds
+    // stepped by stepAll already run in parallel and are best left at 1.
+    void setSolverThreads(unsigned int threadCount);
+
+    // Fixed timestep stepping for a variable frame rate. advance adds the
+    // frame time to an accumulator and takes every whole step of stepSeconds
+    // in it, each as substeps calls to step. A frame takes at most
+    // maxStepsPerFrame steps and drops whatever time is left over beyond one
+    // step, so a long frame costs a bounded amount and the simulation slows
+    // down instead of falling further behind. Every step has the same length,
+    // so the same frame times give the same run. A stepSeconds that is not
+    // positive and finite keeps the previous step length.
+    void setFixedStep(float stepSeconds, int substeps = 1, int maxStepsPerFrame = 8);
+    // Returns the number of fixed steps taken. Handles kept across the call
+    // are updated with scene().Resolve, which covers every step it took
+    int advance(double frameSeconds);
+    // Part of a step left in the accumulator after the last advance, from 0
+    // to 1. It stays 1 for worlds only moved by step
+    float interpolationAlpha() const { return m_interpolationAlpha; }
+    // Transform to draw entity with: for bodies, the pose interpolationAlpha of
+    // the way from before the last fixed step to now. Other entities keep transformMatrix
+    glm::mat4 drawTransform(EntityID entity, const glm::mat4 &transformMatrix);
+
+    // Spatial queries over the bodies with a circle or box shape, answered by
+    // an AABB tree. Bodies are indexed at the end of every step, so bodies
+    // created since the last step are not found yet. Results are exact shape
+    // tests against the current body state.
+
+    // Appends every entity whose shape contains point
+    void queryPoint(const glm::vec2 &point, std::vector<EntityID> &hits);
+    // Appends every entity whose shape overlaps the rectangle
+    void queryAABB(const AABB &region, std::vector<EntityID> &hits);
+    // Closest shape hit by the ray within maxDistance, direction needs not be normalized
+    bool raycast(const glm::vec2 &origin, const glm::vec2 &direction, float maxDistance, RaycastHit &hit);
+
+    bool saveSnapshot(const std::string &path) const;
+    bool loadSnapshot(const std::string &path);
+
+    Scene& scene() { return m_scene; }
+    const Scene& scene() const { return m_scene; }
+    // Contacts of the last step
+    const ContactSolver& contactSolver() const { return m_solver; }
+
+    // Steps every world stepCount times, spread over threadCount threads (0
+    // uses every core). A world is only ever stepped by one thread. onFinished
+    // runs on the worker thread right after a world's last step, with the
+    // world's position in worlds, so it must only write results for that world
+    static void stepAll(const std::vector<World*> &worlds, float deltaTime, size_t stepCount,
+        const std::function<void(size_t, World&)> &onFinished = nullptr, unsigned int threadCount = 0);
+
+private:
+    Scene m_scene;
+    // Tick of the last transform rebuild, bodies changed after it need a new matrix
+    ChangeTick m_transformTick = 0;
+    // Tick of the last query tree update, bodies changed after it may have left their leaf
+    ChangeTick m_treeTick = 0;
+    // Calls to reorganize, paces the spatial sort
+    unsigned int m_stepCount = 0;
+
+    // Fixed timestep state for advance
+    float m_fixedStep = 1.0f / 60.0f;
+    int m_substeps = 1;
+    int m_maxStepsPerFrame = 8;
+    double m_accumulator = 0.0;
+    float m_interpolationAlpha = 1.0f;
+
+    // Shape of a body for the narrowphase, pointers into the component pools
+    struct BodyShape {
+        const CircleComponent *circle = nullptr;
+        const BoxComponent *box = nullptr;
+        // World-space vertices and normals of boxes
+        const WorldShapeComponent *world = nullptr;
+    };
+
+    // Per-step collision buffers, kept to reuse their memory
+    SpatialHash m_broadphase;
+    std::vector<AABB> m_bounds;
+    std::vector<BodyShape> m_shapes;
+    std::vector<BodyPair> m_pairs;
+    ContactSolver m_solver;
+    // Null while contacts are solved on the stepping thread only
+    std::unique_ptr<WorkerPool> m_solverWorkers;
+    // Bodies the broadphase starts pairs from, awake and not static
+    std::vector<uint8_t> m_active;
+
+    // Island building buffers, indexed by body slot
+    std::vector<uint32_t> m_islandParents;
+    std::vector<float> m_islandSleepTimes;
+    std::vector<uint32_t> m_islandTags;
+    // Tag given to the next island that falls asleep
+    uint32_t m_nextIsland = 1;
+    // Tags of sleeping islands to wake at the next wakeIslands call
+    std::vector<uint32_t> m_islandsToWake;
+
+    // Compacts the scene and sorts it every SPATIAL_SORT_INTERVAL calls, once
+    // per step or fixed step whatever the substep count
+    void reorganize();
+    // Body of step without reorganize, leaves the moves of earlier steps in the remap table
+    void simulate(float deltaTime);
+
+    // Times how long each body rested and puts islands that all rested long enough to sleep
+    void updateSleep(float deltaTime);
+    void wakeIslands();
+
+    // Fat bounds of every shaped body for the spatial queries, leaves hold the owning EntityID
+    DynamicTree m_tree;
+    // Moves the tree leaves to where the bodies ended the step
+    void updateTree(float deltaTime);
+};
@@ -1 +0,0 @@
-int s_componentCounter = 0;
@@ -1,9 +1,74 @@
 #pragma once
 
-extern int s_componentCounter;
+#include <type_traits>
+
+#include "components/Components.h"
+
+template<typename... ComponentTypes>
+struct ComponentList {
+    static constexpr int size = sizeof...(ComponentTypes);
+};
+
+// Every component the scene can store. A component's ID is its position in
+// this list, so IDs are known at compile time and identical across builds.
+// Serialized scenes depend on them: only ever append new components.
+using RegisteredComponents = ComponentList<
+    PositionComponent,
+    VelocityComponent,
+    AccelerationComponent,
+    MassComponent,
+    CircleComponent,
+    BoxComponent,
+    CenterOfMassComponent,
+    PolygonComponent,
+    AngularVelocityComponent,
+    AngularAccelerationComponent,
+    InertiaComponent,
+    OrientationComponent,
+    TransformComponent,
+    FrictionComponent,
+    MovingComponent,
+    ColorComponent,
+    RigidBodyComponent,
+    WorldShapeComponent
+>;
+
+static constexpr int COMPONENT_COUNT = RegisteredComponents::size;
+
+template<typename T>
+inline constexpr bool s_unregisteredComponent = false;
+
+template<typename T, typename List>
+struct ComponentIndex;
+
+template<typename T>
+struct ComponentIndex<T, ComponentList<>> {
+    static_assert(s_unregisteredComponent<T>, "Component type is missing from RegisteredComponents");
+    static constexpr int value = -1;
+};
+
+template<typename T, typename... Rest>
+struct ComponentIndex<T, ComponentList<T, Rest...>> {
+    static constexpr int value = 0;
+};
+
+template<typename T, typename First, typename... Rest>
+struct ComponentIndex<T, ComponentList<First, Rest...>> {
+    static constexpr int value = 1 + ComponentIndex<T, ComponentList<Rest...>>::value;
+};
 
 template <class T>
-int GetId() {
-    static int s_componentId = s_componentCounter++;
-    return s_componentId;
-}
\ No newline at end of file
+constexpr int GetId() {
+    return ComponentIndex<T, RegisteredComponents>::value;
+}
+
+template<typename T>
+struct ComponentTag {
+    using type = T;
+};
+
+// Calls fn(ComponentTag<T>{}) for every registered component T, in ID order
+template<typename Fn, typename... ComponentTypes>
+void ForEachComponentType(ComponentList<ComponentTypes...>, Fn&& fn) {
+    (fn(ComponentTag<ComponentTypes>{}), ...);
+}
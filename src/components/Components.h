@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "glm/glm.hpp"
+#include "../physics/ShapeVertices.h"
 
 struct PositionComponent {
     glm::vec3 position{0.0f, 0.0f, 0.0f};
@@ -24,8 +26,9 @@ struct CircleComponent {
     float radius{0.0f};
 };
 
+// Local-space corners of a rectangle, BOX_VERTICES of them
 struct BoxComponent {
-    std::vector<glm::vec3> vertices;
+    ShapeVertices vertices;
 };
 
 struct CenterOfMassComponent {
@@ -33,7 +36,7 @@ struct CenterOfMassComponent {
 };
 
 struct PolygonComponent {
-    std::vector<glm::vec3> vertices{};
+    ShapeVertices vertices{};
     float rotation;
 };
 
@@ -66,4 +69,20 @@ struct MovingComponent {};
 
 struct ColorComponent {
     glm::vec4 color;
-};
\ No newline at end of file
+};
+
+// Slot of the entity's body in Scene::rigidBodies, assigned by the scene
+struct RigidBodyComponent {
+    uint32_t body;
+};
+
+// World-space copy of a body's shape, refreshed by the World once per step
+// for bodies that moved. Normals are the unit edge normals used as SAT axes,
+// normals[i] belongs to the edge from vertices[i] to vertices[i + 1].
+// Circles only fill the bounds.
+struct WorldShapeComponent {
+    ShapeVertices vertices;
+    ShapeVertices normals;
+    glm::vec2 boundsMin{0.0f, 0.0f};
+    glm::vec2 boundsMax{0.0f, 0.0f};
+};
@@ -9,9 +9,9 @@
 #include "imgui_impl_opengl3.h"
 
 #include "Renderer.h"
+#include "World.h"
 #include "Scene.h"
 #include "components/Components.h"
-#include "physics/PhysicsEngine.h"
 #include "shader/Shader.h"
 #include "utils.h"
 #include "gui/GUIManager.h"
@@ -27,8 +27,15 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action,
                  int mods);
 void updateCursorHover(GLFWwindow *window);
 
+// The world moves in fixed steps whatever the frame rate, a frame takes at
+// most MAX_PHYSICS_STEPS_PER_FRAME of them
+const float PHYSICS_STEP = 1.0f / 60.0f;
+const int PHYSICS_SUBSTEPS = 2;
+const int MAX_PHYSICS_STEPS_PER_FRAME = 5;
+
 double deltaTime = 0.0f;
 double lastFrame = 0.0f;
+std::unique_ptr<World> world;
 std::unique_ptr<Renderer> renderer;
 std::unique_ptr<GUIManager> guiManager;
 std::unique_ptr<Shader> shader;
@@ -69,14 +76,16 @@ int main() {
     getFullPath("shaders/vertex_shader.glsl"),
     getFullPath("shaders/fragment_shader.glsl")
   );
-  renderer = std::make_unique<Renderer>();
+  world = std::make_unique<World>();
+  world->setFixedStep(PHYSICS_STEP, PHYSICS_SUBSTEPS, MAX_PHYSICS_STEPS_PER_FRAME);
+  renderer = std::make_unique<Renderer>(*world);
   guiManager = std::make_unique<GUIManager>();
   projection = Transformations::createProjectionMatrix(800, 800);
   renderer->setProjection(projection);
 
   float width = 1.8f;
   float height = 0.1f;
-  renderer->insertStaticBox(glm::vec3(0.0f, -0.8f, 0.0f), width, height, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
+  world->insertStaticBox(glm::vec3(0.0f, -0.8f, 0.0f), width, height, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
 
   glViewport(0, 0, 800, 800);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
@@ -145,6 +154,41 @@ void processInput(GLFWwindow *window) {
 
 void keyCallback(GLFWwindow *window, int key, int scancode, int action,
                  int mods) {
+  if (key == GLFW_KEY_F5 && action == GLFW_RELEASE) {
+    renderer->saveSnapshot(getFullPath("scene.snapshot"));
+  }
+  if (key == GLFW_KEY_F9 && action == GLFW_RELEASE) {
+    renderer->loadSnapshot(getFullPath("scene.snapshot"));
+  }
+  if (key == GLFW_KEY_X && action == GLFW_RELEASE) {
+    // Removes the bodies under the cursor
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    double ndcX, ndcY;
+    pixelToNDC(window, xpos, ypos, &ndcX, &ndcY);
+
+    std::vector<EntityID> picked;
+    world->queryPoint(glm::vec2(ndcX, ndcY), picked);
+    for (EntityID entity : picked) {
+      world->scene().DestroyEntity(entity);
+    }
+  }
+  if (key == GLFW_KEY_B && action == GLFW_RELEASE) {
+    // Drops a 10x10 block of small circles under the cursor in one batch
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    double ndcX, ndcY;
+    pixelToNDC(window, xpos, ypos, &ndcX, &ndcY);
+
+    float radius = 0.01f;
+    std::vector<glm::vec2> centers;
+    for (int row = 0; row < 10; row++) {
+      for (int column = 0; column < 10; column++) {
+        centers.emplace_back(ndcX + (column - 4.5f) * radius * 2.5f, ndcY + (row - 4.5f) * radius * 2.5f);
+      }
+    }
+    world->insertCircles(centers, radius, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
+  }
   if (key == GLFW_KEY_D && action == GLFW_RELEASE) {
     if (isPointerCursor) {
       if (polygonToInsert.size() > 2) {
@@ -177,7 +221,7 @@ void mouse_button_callback(GLFWwindow *window, int button, int action,
     pixelToNDC(window, xpos, ypos, &ndcX, &ndcY);
 
     float radius = 0.05f;
-    renderer->insertCircle(ndcX, ndcY, radius, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
+    world->insertCircle(ndcX, ndcY, radius, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
   }
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS &&
       isPointerCursor) {
@@ -196,7 +240,7 @@ void mouse_button_callback(GLFWwindow *window, int button, int action,
     pixelToNDC(window, xpos, ypos, &ndcX, &ndcY);
     float width = 0.1f;
     float height = 0.1f;
-    renderer->insertBox(glm::vec3(ndcX, ndcY, 0.0f), width, height, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
+    world->insertBox(glm::vec3(ndcX, ndcY, 0.0f), width, height, glm::vec4(guiManager->GetSelectedColor(), 1.0f));
   }
 }
 
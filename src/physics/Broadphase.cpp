@@ -0,0 +1,154 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Bodies spanning more cells than this skip the grid, like a long static floor
+static constexpr int64_t MAX_CELLS_PER_BODY = 64;
+// Keeps far away bodies from overflowing the cell coordinates
+static constexpr float MAX_CELL_COORDINATE = 1 << 30;
+
+static int32_t cellCoordinate(float value, float inverseCellSize) {
+    float cell = std::floor(value * inverseCellSize);
+    return static_cast<int32_t>(std::clamp(cell, -MAX_CELL_COORDINATE, MAX_CELL_COORDINATE));
+}
+
+static uint64_t cellKey(int32_t cellX, int32_t cellY) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+}
+
+bool SpatialHash::cellRange(const AABB &box, int32_t &x0, int32_t &y0, int32_t &x1, int32_t &y1) const {
+    x0 = cellCoordinate(box.minX, m_inverseCellSize);
+    y0 = cellCoordinate(box.minY, m_inverseCellSize);
+    x1 = cellCoordinate(box.maxX, m_inverseCellSize);
+    y1 = cellCoordinate(box.maxY, m_inverseCellSize);
+    return int64_t(x1 - x0 + 1) * int64_t(y1 - y0 + 1) <= MAX_CELLS_PER_BODY;
+}
+
+bool SpatialHash::ownsOverlap(const AABB &first, const AABB &second, int32_t cellX, int32_t cellY) const {
+    return cellCoordinate(std::max(first.minX, second.minX), m_inverseCellSize) == cellX &&
+        cellCoordinate(std::max(first.minY, second.minY), m_inverseCellSize) == cellY;
+}
+
+void SpatialHash::findPairs(const std::vector<AABB> &bounds, std::vector<BodyPair> &pairs) {
+    m_allActive.assign(bounds.size(), 1);
+    findPairs(bounds, m_allActive, pairs);
+}
+
+void SpatialHash::findPairs(const std::vector<AABB> &bounds, const std::vector<uint8_t> &active, std::vector<BodyPair> &pairs) {
+    pairs.clear();
+    m_entries.clear();
+    m_largeBodies.clear();
+
+    // Cells about twice the average body size keep most bodies in one to four cells
+    double extent = 0.0;
+    size_t count = 0;
+    size_t activeCount = 0;
+    for (uint32_t body = 0; body < bounds.size(); body++) {
+        const AABB &box = bounds[body];
+        if (!box.empty()) {
+            extent += std::max(box.maxX - box.minX, box.maxY - box.minY);
+            count++;
+            activeCount += active[body] ? 1 : 0;
+        }
+    }
+    if (count < 2 || activeCount == 0) {
+        return;
+    }
+    m_cellSize = std::max(static_cast<float>(2.0 * extent / count), 1e-4f);
+    m_inverseCellSize = 1.0f / m_cellSize;
+
+    for (uint32_t body = 0; body < bounds.size(); body++) {
+        const AABB &box = bounds[body];
+        if (box.empty()) {
+            continue;
+        }
+        int32_t x0, y0, x1, y1;
+        if (!cellRange(box, x0, y0, x1, y1)) {
+            m_largeBodies.push_back(body);
+            continue;
+        }
+        if (!active[body]) {
+            continue;
+        }
+        for (int32_t cellY = y0; cellY <= y1; cellY++) {
+            for (int32_t cellX = x0; cellX <= x1; cellX++) {
+                m_entries.push_back({ cellKey(cellX, cellY), body });
+            }
+        }
+    }
+
+    // Groups bodies by cell, ascending body index inside each cell
+    std::sort(m_entries.begin(), m_entries.end(), [](const CellEntry &left, const CellEntry &right) {
+        return left.cell != right.cell ? left.cell < right.cell : left.body < right.body;
+    });
+
+    for (size_t begin = 0; begin < m_entries.size();) {
+        uint64_t cell = m_entries[begin].cell;
+        size_t end = begin + 1;
+        while (end < m_entries.size() && m_entries[end].cell == cell) {
+            end++;
+        }
+        int32_t cellX = static_cast<int32_t>(cell >> 32);
+        int32_t cellY = static_cast<int32_t>(static_cast<uint32_t>(cell));
+
+        for (size_t i = begin; i < end; i++) {
+            const AABB &first = bounds[m_entries[i].body];
+            for (size_t j = i + 1; j < end; j++) {
+                const AABB &second = bounds[m_entries[j].body];
+                if (first.overlaps(second) && ownsOverlap(first, second, cellX, cellY)) {
+                    pairs.push_back({ m_entries[i].body, m_entries[j].body });
+                }
+            }
+        }
+        begin = end;
+    }
+
+    // Inactive bodies meet the active ones of every cell they touch
+    if (activeCount < count) {
+        for (uint32_t body = 0; body < bounds.size(); body++) {
+            const AABB &box = bounds[body];
+            int32_t x0, y0, x1, y1;
+            if (active[body] || box.empty() || !cellRange(box, x0, y0, x1, y1)) {
+                continue;
+            }
+            for (int32_t cellY = y0; cellY <= y1; cellY++) {
+                for (int32_t cellX = x0; cellX <= x1; cellX++) {
+                    uint64_t cell = cellKey(cellX, cellY);
+                    auto entry = std::lower_bound(m_entries.begin(), m_entries.end(), cell, [](const CellEntry &left, uint64_t key) {
+                        return left.cell < key;
+                    });
+                    for (; entry != m_entries.end() && entry->cell == cell; ++entry) {
+                        const AABB &other = bounds[entry->body];
+                        if (box.overlaps(other) && ownsOverlap(box, other, cellX, cellY)) {
+                            pairs.push_back({ std::min(body, entry->body), std::max(body, entry->body) });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Large bodies are few, a straight scan against every other body is enough.
+    // An inactive one only reports active small bodies, active large ones report it themselves
+    for (uint32_t large : m_largeBodies) {
+        for (uint32_t other = 0; other < bounds.size(); other++) {
+            if (other == large || bounds[other].empty() || !bounds[large].overlaps(bounds[other])) {
+                continue;
+            }
+            bool otherLarge = std::binary_search(m_largeBodies.begin(), m_largeBodies.end(), other);
+            if (!active[large] && (!active[other] || otherLarge)) {
+                continue;
+            }
+            // Two active large bodies see each other twice, keep it from the lower index
+            if (otherLarge && active[other] && other < large) {
+                continue;
+            }
+            pairs.push_back({ std::min(large, other), std::max(large, other) });
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end(), [](const BodyPair &left, const BodyPair &right) {
+        return left.a != right.a ? left.a < right.a : left.b < right.b;
+    });
+}
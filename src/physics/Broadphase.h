@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// World-space bounds of one body. Bodies without a shape get empty bounds
+// (min above max) and never take part in a pair.
+struct AABB {
+    float minX, minY, maxX, maxY;
+
+    bool empty() const {
+        return minX > maxX || minY > maxY;
+    }
+
+    bool overlaps(const AABB &other) const {
+        return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+    }
+};
+
+// Two bodies whose bounds overlap, always with a < b
+struct BodyPair {
+    uint32_t a, b;
+};
+
+// Uniform grid stored as a sorted list of (cell, body) entries, so only
+// occupied cells cost memory. Each body is inserted into every cell its bounds
+// touch and only bodies sharing a cell are tested against each other.
+class SpatialHash {
+public:
+    // Replaces pairs with every overlapping pair of bounds, indexed like bounds.
+    // Each pair is reported once and the list is sorted, so the order only
+    // depends on the input.
+    void findPairs(const std::vector<AABB> &bounds, std::vector<BodyPair> &pairs);
+    // Same, but only pairs with at least one body flagged in active. Only
+    // active bodies go into the grid, the others look up the cells they touch,
+    // so a mostly inactive scene costs little more than its active part.
+    void findPairs(const std::vector<AABB> &bounds, const std::vector<uint8_t> &active, std::vector<BodyPair> &pairs);
+
+    float cellSize() const {
+        return m_cellSize;
+    }
+
+private:
+    struct CellEntry {
+        uint64_t cell;
+        uint32_t body;
+    };
+
+    float m_cellSize = 0.0f;
+    float m_inverseCellSize = 0.0f;
+    // Reused between calls to avoid reallocating every step
+    std::vector<CellEntry> m_entries;
+    // Bodies covering too many cells, tested against everything instead
+    std::vector<uint32_t> m_largeBodies;
+    std::vector<uint8_t> m_allActive;
+
+    // Cell range covered by bounds, false when it is too large for the grid
+    bool cellRange(const AABB &box, int32_t &x0, int32_t &y0, int32_t &x1, int32_t &y1) const;
+    // Whether the cell holds the lower corner of the overlap of first and second,
+    // so a pair sharing several cells is reported from one of them only
+    bool ownsOverlap(const AABB &first, const AABB &second, int32_t cellX, int32_t cellY) const;
+};
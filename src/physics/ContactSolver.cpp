@@ -0,0 +1,470 @@
+#include "ContactSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Transformations.h"
+#include "../WorkerPool.h"
+
+// Approach speeds below this do not bounce, so resting contacts settle
+static constexpr float RESTITUTION_THRESHOLD = 0.5f;
+// Overlap left alone by the position pass, so resting contacts keep touching
+static constexpr float LINEAR_SLOP = 0.002f;
+// Share of the remaining overlap removed per position iteration, and the most one iteration moves a contact
+static constexpr float POSITION_CORRECTION = 0.4f;
+static constexpr float MAX_LINEAR_CORRECTION = 0.02f;
+// Two points whose normal rows are closer to parallel than this are kept as one
+static constexpr float MAX_BLOCK_CONDITION = 1000.0f;
+// Colors a contact can get, the last one takes whatever does not fit the others and is solved on one thread
+static constexpr uint32_t COLOR_COUNT = 64;
+static constexpr uint32_t OVERFLOW_COLOR = COLOR_COUNT - 1;
+// Contacts per task when a color is split over the workers
+static constexpr size_t CONTACTS_PER_TASK = 64;
+static constexpr size_t ROWS_PER_TASK = CONTACTS_PER_TASK / CONTACT_LANES;
+
+static glm::vec2 crossScalar(float omega, const glm::vec2 &r) {
+    return glm::vec2(-omega * r.y, omega * r.x);
+}
+
+// Velocity of the contact point on B relative to the one on A
+static glm::vec2 relativeVelocity(const RigidBodies &bodies, const ContactConstraint &constraint, const ContactPoint &point) {
+    uint32_t a = constraint.bodyA;
+    uint32_t b = constraint.bodyB;
+    glm::vec2 velocityA = glm::vec2(bodies.vx[a], bodies.vy[a]) + crossScalar(bodies.omega[a], point.rA);
+    glm::vec2 velocityB = glm::vec2(bodies.vx[b], bodies.vy[b]) + crossScalar(bodies.omega[b], point.rB);
+    return velocityB - velocityA;
+}
+
+static void applyImpulse(RigidBodies &bodies, const ContactConstraint &constraint, const ContactPoint &point, const glm::vec2 &impulse) {
+    uint32_t a = constraint.bodyA;
+    uint32_t b = constraint.bodyB;
+    if (!bodies.isStatic(a)) {
+        bodies.vx[a] -= impulse.x * bodies.invMass[a];
+        bodies.vy[a] -= impulse.y * bodies.invMass[a];
+        bodies.omega[a] -= Transformations::cross(point.rA, impulse) * bodies.invInertia[a];
+    }
+    if (!bodies.isStatic(b)) {
+        bodies.vx[b] += impulse.x * bodies.invMass[b];
+        bodies.vy[b] += impulse.y * bodies.invMass[b];
+        bodies.omega[b] += Transformations::cross(point.rB, impulse) * bodies.invInertia[b];
+    }
+}
+
+static float effectiveMass(const RigidBodies &bodies, const ContactConstraint &constraint, const ContactPoint &point, const glm::vec2 &direction) {
+    uint32_t a = constraint.bodyA;
+    uint32_t b = constraint.bodyB;
+    float rnA = Transformations::cross(point.rA, direction);
+    float rnB = Transformations::cross(point.rB, direction);
+    float k = bodies.invMass[a] + bodies.invMass[b] + rnA * rnA * bodies.invInertia[a] + rnB * rnB * bodies.invInertia[b];
+    return k > 0.0f ? 1.0f / k : 0.0f;
+}
+
+static glm::vec2 tangentOf(const glm::vec2 &normal) {
+    return glm::vec2(normal.y, -normal.x);
+}
+
+void ContactSolver::beginStep() {
+    m_previous.swap(m_constraints);
+    m_constraints.clear();
+    m_previousIndex.clear();
+    for (uint32_t i = 0; i < m_previous.size(); i++) {
+        m_previousIndex[{ m_previous[i].ownerA, m_previous[i].ownerB }] = i;
+    }
+}
+
+void ContactSolver::add(const RigidBodies &bodies, uint32_t a, uint32_t b, const Manifold &m) {
+    ContactConstraint constraint{};
+    constraint.ownerA = bodies.owners[a];
+    constraint.ownerB = bodies.owners[b];
+    constraint.bodyA = a;
+    constraint.bodyB = b;
+    constraint.normal = glm::vec2(m.normal.x, m.normal.y);
+    constraint.staticFriction = (bodies.staticFriction[a] + bodies.staticFriction[b]) * 0.5f;
+    constraint.dynamicFriction = (bodies.dynamicFriction[a] + bodies.dynamicFriction[b]) * 0.5f;
+    constraint.restitution = std::max(bodies.restitution[a], bodies.restitution[b]);
+    constraint.pointCount = m.nContacts;
+
+    auto previous = m_previousIndex.find({ constraint.ownerA, constraint.ownerB });
+    glm::vec2 centerA(bodies.x[a], bodies.y[a]);
+    glm::vec2 centerB(bodies.x[b], bodies.y[b]);
+    const glm::vec3 *contacts[2] = { &m.contactPoint1, &m.contactPoint2 };
+    const uint32_t features[2] = { m.featureId1, m.featureId2 };
+    const float separations[2] = { m.separation1, m.separation2 };
+
+    for (int i = 0; i < constraint.pointCount; i++) {
+        ContactPoint &point = constraint.points[i];
+        glm::vec2 contact(contacts[i]->x, contacts[i]->y);
+        point.rA = contact - centerA;
+        point.rB = contact - centerB;
+        point.featureId = features[i];
+        point.separation = separations[i];
+        point.normalMass = effectiveMass(bodies, constraint, point, constraint.normal);
+        point.tangentMass = effectiveMass(bodies, constraint, point, tangentOf(constraint.normal));
+
+        float approachSpeed = glm::dot(relativeVelocity(bodies, constraint, point), constraint.normal);
+        point.velocityBias = approachSpeed < -RESTITUTION_THRESHOLD ? -constraint.restitution * approachSpeed : 0.0f;
+
+        if (previous != m_previousIndex.end()) {
+            const ContactConstraint &old = m_previous[previous->second];
+            for (int j = 0; j < old.pointCount; j++) {
+                if (old.points[j].featureId == point.featureId) {
+                    point.normalImpulse = old.points[j].normalImpulse;
+                    point.tangentImpulse = old.points[j].tangentImpulse;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Both points share the normal, so the impulse at one changes the speed at
+    // the other. Nearly the same point twice cannot be inverted, keep the first
+    if (constraint.pointCount == 2) {
+        const ContactPoint &first = constraint.points[0];
+        const ContactPoint &second = constraint.points[1];
+        float rnA1 = Transformations::cross(first.rA, constraint.normal);
+        float rnB1 = Transformations::cross(first.rB, constraint.normal);
+        float rnA2 = Transformations::cross(second.rA, constraint.normal);
+        float rnB2 = Transformations::cross(second.rB, constraint.normal);
+        float invMass = bodies.invMass[a] + bodies.invMass[b];
+        float k11 = invMass + rnA1 * rnA1 * bodies.invInertia[a] + rnB1 * rnB1 * bodies.invInertia[b];
+        float k22 = invMass + rnA2 * rnA2 * bodies.invInertia[a] + rnB2 * rnB2 * bodies.invInertia[b];
+        float k12 = invMass + rnA1 * rnA2 * bodies.invInertia[a] + rnB1 * rnB2 * bodies.invInertia[b];
+        float determinant = k11 * k22 - k12 * k12;
+        if (k11 * k11 < MAX_BLOCK_CONDITION * determinant) {
+            float inverse = 1.0f / determinant;
+            constraint.blockK[0] = k11;
+            constraint.blockK[1] = k12;
+            constraint.blockK[2] = k22;
+            constraint.blockMass[0] = k22 * inverse;
+            constraint.blockMass[1] = -k12 * inverse;
+            constraint.blockMass[2] = k11 * inverse;
+        } else {
+            constraint.pointCount = 1;
+        }
+    }
+    m_constraints.push_back(constraint);
+}
+
+static void warmStart(RigidBodies &bodies, const ContactConstraint &constraint) {
+    glm::vec2 tangent = tangentOf(constraint.normal);
+    for (int i = 0; i < constraint.pointCount; i++) {
+        const ContactPoint &point = constraint.points[i];
+        applyImpulse(bodies, constraint, point, point.normalImpulse * constraint.normal + point.tangentImpulse * tangent);
+    }
+}
+
+// Normal impulses of a two point contact, found together so that neither
+// point pushes the body over the other. Tries both points pushing, then only
+// the first, only the second and neither, keeping the first case whose
+// impulses push and whose points do not approach. Returns the accumulated
+// impulses unchanged when no case fits
+static void solveNormalBlock(const ContactConstraint &constraint, float speed1, float speed2, float &impulse1, float &impulse2) {
+    const ContactPoint &first = constraint.points[0];
+    const ContactPoint &second = constraint.points[1];
+    const float *k = constraint.blockK;
+    const float *mass = constraint.blockMass;
+    float old1 = first.normalImpulse;
+    float old2 = second.normalImpulse;
+    // Speeds left once the accumulated impulses are taken back out
+    float b1 = (speed1 - first.velocityBias) - (k[0] * old1 + k[1] * old2);
+    float b2 = (speed2 - second.velocityBias) - (k[1] * old1 + k[2] * old2);
+
+    impulse1 = -(mass[0] * b1 + mass[1] * b2);
+    impulse2 = -(mass[1] * b1 + mass[2] * b2);
+    if (impulse1 >= 0.0f && impulse2 >= 0.0f) {
+        return;
+    }
+    impulse1 = -(first.normalMass * b1);
+    impulse2 = 0.0f;
+    if (impulse1 >= 0.0f && k[1] * impulse1 + b2 >= 0.0f) {
+        return;
+    }
+    impulse1 = 0.0f;
+    impulse2 = -(second.normalMass * b2);
+    if (impulse2 >= 0.0f && k[1] * impulse2 + b1 >= 0.0f) {
+        return;
+    }
+    impulse1 = 0.0f;
+    impulse2 = 0.0f;
+    if (b1 >= 0.0f && b2 >= 0.0f) {
+        return;
+    }
+    impulse1 = old1;
+    impulse2 = old2;
+}
+
+static void solveVelocities(RigidBodies &bodies, ContactConstraint &constraint) {
+    glm::vec2 tangent = tangentOf(constraint.normal);
+    for (int i = 0; i < constraint.pointCount; i++) {
+        ContactPoint &point = constraint.points[i];
+
+        // Friction first, bounded by the normal impulse of the previous iteration. The
+        // contact sticks up to static friction, past it it slides with dynamic friction
+        float tangentSpeed = glm::dot(relativeVelocity(bodies, constraint, point), tangent);
+        float tangentImpulse = point.tangentImpulse - point.tangentMass * tangentSpeed;
+        if (std::abs(tangentImpulse) > constraint.staticFriction * point.normalImpulse) {
+            float limit = constraint.dynamicFriction * point.normalImpulse;
+            tangentImpulse = std::clamp(tangentImpulse, -limit, limit);
+        }
+        applyImpulse(bodies, constraint, point, (tangentImpulse - point.tangentImpulse) * tangent);
+        point.tangentImpulse = tangentImpulse;
+    }
+
+    // The accumulated normal impulse can only push
+    ContactPoint &first = constraint.points[0];
+    float speed1 = glm::dot(relativeVelocity(bodies, constraint, first), constraint.normal);
+    if (constraint.pointCount == 1) {
+        float normalImpulse = std::max(first.normalImpulse + first.normalMass * (first.velocityBias - speed1), 0.0f);
+        applyImpulse(bodies, constraint, first, (normalImpulse - first.normalImpulse) * constraint.normal);
+        first.normalImpulse = normalImpulse;
+        return;
+    }
+    ContactPoint &second = constraint.points[1];
+    float speed2 = glm::dot(relativeVelocity(bodies, constraint, second), constraint.normal);
+    float impulse1, impulse2;
+    solveNormalBlock(constraint, speed1, speed2, impulse1, impulse2);
+    applyImpulse(bodies, constraint, first, (impulse1 - first.normalImpulse) * constraint.normal);
+    applyImpulse(bodies, constraint, second, (impulse2 - second.normalImpulse) * constraint.normal);
+    first.normalImpulse = impulse1;
+    second.normalImpulse = impulse2;
+}
+
+// Runs fn on every contact, one color after the other. Large colors are split
+// over the workers, the overflow color stays on the calling thread
+template<typename Fn>
+static void forEachColor(std::vector<ContactConstraint> &constraints, const std::vector<size_t> &colorOffsets,
+    WorkerPool *workers, Fn&& fn) {
+    for (size_t color = 0; color + 1 < colorOffsets.size(); color++) {
+        ContactConstraint *first = constraints.data() + colorOffsets[color];
+        size_t count = colorOffsets[color + 1] - colorOffsets[color];
+        auto solveRange = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                fn(first[i]);
+            }
+        };
+        if (workers != nullptr && color != OVERFLOW_COLOR) {
+            workers->parallelFor(count, CONTACTS_PER_TASK, solveRange);
+        } else {
+            solveRange(0, count);
+        }
+    }
+}
+
+void ContactSolver::colorConstraints(const RigidBodies &bodies) {
+    // Greedy coloring in contact order: the lowest color neither body uses yet
+    m_bodyColors.assign(bodies.size(), 0);
+    m_constraintColors.resize(m_constraints.size());
+    m_colorOffsets.assign(COLOR_COUNT + 1, 0);
+    for (size_t i = 0; i < m_constraints.size(); i++) {
+        uint32_t a = m_constraints[i].bodyA;
+        uint32_t b = m_constraints[i].bodyB;
+        // Static bodies are only read, so any number of contacts of one color may share them
+        bool movesA = !bodies.isStatic(a);
+        bool movesB = !bodies.isStatic(b);
+        uint64_t used = (movesA ? m_bodyColors[a] : 0) | (movesB ? m_bodyColors[b] : 0);
+
+        uint32_t color = 0;
+        while (color < OVERFLOW_COLOR && (used >> color) & 1) {
+            color++;
+        }
+        if (color != OVERFLOW_COLOR) {
+            uint64_t bit = uint64_t(1) << color;
+            m_bodyColors[a] |= movesA ? bit : 0;
+            m_bodyColors[b] |= movesB ? bit : 0;
+        }
+        m_constraintColors[i] = static_cast<uint8_t>(color);
+        m_colorOffsets[color + 1]++;
+    }
+
+    for (uint32_t color = 0; color < COLOR_COUNT; color++) {
+        m_colorOffsets[color + 1] += m_colorOffsets[color];
+    }
+    m_scratch.resize(m_constraints.size());
+    std::vector<size_t> &next = m_colorStarts;
+    next.assign(m_colorOffsets.begin(), m_colorOffsets.end() - 1);
+    for (size_t i = 0; i < m_constraints.size(); i++) {
+        m_scratch[next[m_constraintColors[i]]++] = m_constraints[i];
+    }
+    m_constraints.swap(m_scratch);
+}
+
+void ContactSolver::buildRows(const RigidBodies &bodies) {
+    m_rowOffsets.assign(OVERFLOW_COLOR + 1, 0);
+    for (uint32_t color = 0; color < OVERFLOW_COLOR; color++) {
+        size_t count = m_colorOffsets[color + 1] - m_colorOffsets[color];
+        m_rowOffsets[color + 1] = m_rowOffsets[color] + (count + CONTACT_LANES - 1) / CONTACT_LANES;
+    }
+    m_rows.resize(m_rowOffsets[OVERFLOW_COLOR]);
+
+    for (uint32_t color = 0; color < OVERFLOW_COLOR; color++) {
+        for (size_t row = m_rowOffsets[color]; row < m_rowOffsets[color + 1]; row++) {
+            ContactRows &rows = m_rows[row];
+            rows = ContactRows{};
+            size_t first = m_colorOffsets[color] + (row - m_rowOffsets[color]) * CONTACT_LANES;
+            size_t laneCount = std::min(CONTACT_LANES, m_colorOffsets[color + 1] - first);
+            for (size_t lane = 0; lane < CONTACT_LANES; lane++) {
+                const ContactConstraint &constraint = m_constraints[first + std::min(lane, laneCount - 1)];
+                rows.bodyA[lane] = constraint.bodyA;
+                rows.bodyB[lane] = constraint.bodyB;
+                if (lane >= laneCount) {
+                    continue;
+                }
+
+                uint32_t a = constraint.bodyA;
+                uint32_t b = constraint.bodyB;
+                glm::vec2 tangent = tangentOf(constraint.normal);
+                rows.movesA[lane] = bodies.isStatic(a) ? 0 : ~0u;
+                rows.movesB[lane] = bodies.isStatic(b) ? 0 : ~0u;
+                rows.normalX[lane] = constraint.normal.x;
+                rows.normalY[lane] = constraint.normal.y;
+                rows.tangentX[lane] = tangent.x;
+                rows.tangentY[lane] = tangent.y;
+                rows.invMassA[lane] = bodies.invMass[a];
+                rows.invMassB[lane] = bodies.invMass[b];
+                rows.invInertiaA[lane] = bodies.invInertia[a];
+                rows.invInertiaB[lane] = bodies.invInertia[b];
+                rows.staticFriction[lane] = constraint.staticFriction;
+                rows.dynamicFriction[lane] = constraint.dynamicFriction;
+                if (constraint.pointCount == 2) {
+                    rows.blockK11[lane] = constraint.blockK[0];
+                    rows.blockK12[lane] = constraint.blockK[1];
+                    rows.blockK22[lane] = constraint.blockK[2];
+                    rows.blockMass11[lane] = constraint.blockMass[0];
+                    rows.blockMass12[lane] = constraint.blockMass[1];
+                    rows.blockMass22[lane] = constraint.blockMass[2];
+                }
+                for (int i = 0; i < constraint.pointCount; i++) {
+                    const ContactPoint &point = constraint.points[i];
+                    ContactRows::Point &lanes = rows.points[i];
+                    lanes.active[lane] = ~0u;
+                    lanes.perpAX[lane] = -point.rA.y;
+                    lanes.perpAY[lane] = point.rA.x;
+                    lanes.perpBX[lane] = -point.rB.y;
+                    lanes.perpBY[lane] = point.rB.x;
+                    lanes.normalMass[lane] = point.normalMass;
+                    lanes.tangentMass[lane] = point.tangentMass;
+                    lanes.velocityBias[lane] = point.velocityBias;
+                    lanes.normalImpulse[lane] = point.normalImpulse;
+                    lanes.tangentImpulse[lane] = point.tangentImpulse;
+                }
+            }
+        }
+    }
+}
+
+void ContactSolver::storeRowImpulses() {
+    for (uint32_t color = 0; color < OVERFLOW_COLOR; color++) {
+        for (size_t i = m_colorOffsets[color]; i < m_colorOffsets[color + 1]; i++) {
+            size_t index = i - m_colorOffsets[color];
+            const ContactRows &rows = m_rows[m_rowOffsets[color] + index / CONTACT_LANES];
+            ContactConstraint &constraint = m_constraints[i];
+            for (int point = 0; point < constraint.pointCount; point++) {
+                constraint.points[point].normalImpulse = rows.points[point].normalImpulse[index % CONTACT_LANES];
+                constraint.points[point].tangentImpulse = rows.points[point].tangentImpulse[index % CONTACT_LANES];
+            }
+        }
+    }
+}
+
+void ContactSolver::solve(RigidBodies &bodies, int iterations, WorkerPool *workers) {
+    colorConstraints(bodies);
+
+    if (m_kernel == SatKernels::Kind::Scalar) {
+        forEachColor(m_constraints, m_colorOffsets, workers, [&](ContactConstraint &constraint) {
+            warmStart(bodies, constraint);
+        });
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            forEachColor(m_constraints, m_colorOffsets, workers, [&](ContactConstraint &constraint) {
+                solveVelocities(bodies, constraint);
+            });
+        }
+        return;
+    }
+
+    // Same color order as above, the rows of each color and then the overflow contacts
+    buildRows(bodies);
+    auto solvePass = [&](auto rowPass, auto constraintPass) {
+        for (uint32_t color = 0; color < OVERFLOW_COLOR; color++) {
+            ContactRows *first = m_rows.data() + m_rowOffsets[color];
+            size_t count = m_rowOffsets[color + 1] - m_rowOffsets[color];
+            auto solveRange = [&](size_t begin, size_t end) {
+                rowPass(m_kernel, first + begin, end - begin, bodies);
+            };
+            if (workers != nullptr) {
+                workers->parallelFor(count, ROWS_PER_TASK, solveRange);
+            } else {
+                solveRange(0, count);
+            }
+        }
+        for (size_t i = m_colorOffsets[OVERFLOW_COLOR]; i < m_colorOffsets[COLOR_COUNT]; i++) {
+            constraintPass(bodies, m_constraints[i]);
+        }
+    };
+    solvePass(SolverKernels::warmStart, warmStart);
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        solvePass(SolverKernels::solveVelocities, solveVelocities);
+    }
+    storeRowImpulses();
+}
+
+void ContactSolver::solvePositions(RigidBodies &bodies, int iterations, WorkerPool *workers) {
+    m_positionDeltas.assign(bodies.size(), PositionDelta{ glm::vec2(0.0f), 0.0f });
+
+    // Nonlinear Gauss-Seidel on the linearized separation: the narrowphase
+    // one plus how far the bodies and their contact offsets moved since
+    auto solveContact = [&](ContactConstraint &constraint) {
+        uint32_t a = constraint.bodyA;
+        uint32_t b = constraint.bodyB;
+        PositionDelta &deltaA = m_positionDeltas[a];
+        PositionDelta &deltaB = m_positionDeltas[b];
+        bool movesA = !bodies.isStatic(a);
+        bool movesB = !bodies.isStatic(b);
+        // Both points are measured before either moves the bodies, so an even
+        // overlap along a face pushes straight out instead of tipping the body
+        glm::vec2 impulses[2];
+        for (int i = 0; i < constraint.pointCount; i++) {
+            const ContactPoint &point = constraint.points[i];
+            glm::vec2 moveA = deltaA.linear + crossScalar(deltaA.angular, point.rA);
+            glm::vec2 moveB = deltaB.linear + crossScalar(deltaB.angular, point.rB);
+            float separation = point.separation + glm::dot(moveB - moveA, constraint.normal);
+            float correction = std::clamp(POSITION_CORRECTION * (separation + LINEAR_SLOP), -MAX_LINEAR_CORRECTION, 0.0f);
+            impulses[i] = -point.normalMass * correction * constraint.normal;
+        }
+        for (int i = 0; i < constraint.pointCount; i++) {
+            const ContactPoint &point = constraint.points[i];
+            if (movesA) {
+                deltaA.linear -= impulses[i] * bodies.invMass[a];
+                deltaA.angular -= Transformations::cross(point.rA, impulses[i]) * bodies.invInertia[a];
+            }
+            if (movesB) {
+                deltaB.linear += impulses[i] * bodies.invMass[b];
+                deltaB.angular += Transformations::cross(point.rB, impulses[i]) * bodies.invInertia[b];
+            }
+        }
+    };
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        forEachColor(m_constraints, m_colorOffsets, workers, solveContact);
+    }
+
+    for (size_t body = 0; body < bodies.size(); body++) {
+        const PositionDelta &delta = m_positionDeltas[body];
+        bodies.x[body] += delta.linear.x;
+        bodies.y[body] += delta.linear.y;
+        bodies.angle[body] += delta.angular;
+    }
+}
+
+bool ContactSolver::setKernel(SatKernels::Kind kind) {
+    if (!SatKernels::supported(kind)) {
+        return false;
+    }
+    m_kernel = kind;
+    return true;
+}
+
+void ContactSolver::clear() {
+    m_constraints.clear();
+    m_previous.clear();
+    m_previousIndex.clear();
+    m_rows.clear();
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Manifold.h"
+#include "RigidBodies.h"
+#include "SatKernels.h"
+#include "SolverKernels.h"
+#include "glm/glm.hpp"
+
+class WorkerPool;
+
+// One point of a contact, with the impulses accumulated on it
+struct ContactPoint {
+    // Offsets from each body's center to the point
+    glm::vec2 rA, rB;
+    float normalMass, tangentMass;
+    // Normal velocity the contact should leave with, from restitution
+    float velocityBias;
+    // Distance along the normal when the contact was found, negative while overlapping
+    float separation;
+    float normalImpulse, tangentImpulse;
+    uint32_t featureId;
+};
+
+// Every contact point between two bodies, the normal points from A to B
+struct ContactConstraint {
+    EntityID ownerA, ownerB;
+    uint32_t bodyA, bodyB;
+    glm::vec2 normal;
+    float staticFriction, dynamicFriction;
+    float restitution;
+    int pointCount;
+    ContactPoint points[2];
+    // With two points their normal impulses are solved together: blockK is
+    // the 2x2 effective mass matrix as k11, k12, k22 and blockMass its inverse
+    float blockK[3], blockMass[3];
+};
+
+// Sequential impulse solver. Collects every contact of a step, then runs
+// velocity iterations that clamp the accumulated impulse of each point
+// rather than each single correction. Contacts are kept from one step to
+// the next, keyed by the owners of the pair and the feature of each point,
+// and a contact seen again starts from its previous impulses. The normal
+// impulses of a two point contact are solved together, so a box resting on
+// a face is not tipped by whichever corner comes first.
+//
+// Overlap is removed afterwards by a separate position pass, which pushes the
+// bodies apart without giving them velocity, so a deep stack does not bounce.
+//
+// Before solving, contacts are colored so that no moving body appears twice
+// in a color, and the colors are solved one after the other. Contacts of one
+// color touch different bodies, so they can be solved on several threads at
+// once and the result does not depend on the thread count. With a SIMD
+// kernel, the contacts of a color are packed into rows and solved
+// CONTACT_LANES at a time. Contacts that fit no color stay one at a time.
+class ContactSolver {
+public:
+    // Last step's contacts become the warm start source for this one
+    void beginStep();
+    // Adds a touching pair. Pairs must come with the same order of A and B every step to be matched
+    void add(const RigidBodies &bodies, uint32_t a, uint32_t b, const Manifold &m);
+    // Applies the warm start impulses and runs the velocity iterations, on
+    // the workers when given
+    void solve(RigidBodies &bodies, int iterations, WorkerPool *workers = nullptr);
+    // Moves the bodies of the solved contacts apart until they overlap by
+    // about the slop, measuring each contact's separation from the moves made
+    // so far. Runs on the colors of the last solve
+    void solvePositions(RigidBodies &bodies, int iterations, WorkerPool *workers = nullptr);
+
+    // Owners changed ID, resolve(id) gives the new ID of every owner
+    template<typename Fn>
+    void remapOwners(Fn&& resolve) {
+        for (ContactConstraint &constraint : m_constraints) {
+            constraint.ownerA = resolve(constraint.ownerA);
+            constraint.ownerB = resolve(constraint.ownerB);
+        }
+    }
+
+    void clear();
+
+    // Kernel of the velocity iterations, the widest supported one by default.
+    // Returns false, keeping the current one, when kind is not supported
+    bool setKernel(SatKernels::Kind kind);
+    SatKernels::Kind kernel() const {
+        return m_kernel;
+    }
+
+    // Grouped by color once solve has run
+    const std::vector<ContactConstraint>& constraints() const {
+        return m_constraints;
+    }
+
+    // Colors holding at least one contact in the last solve
+    size_t colorCount() const {
+        size_t count = 0;
+        for (size_t color = 0; color + 1 < m_colorOffsets.size(); color++) {
+            count += m_colorOffsets[color + 1] > m_colorOffsets[color] ? 1 : 0;
+        }
+        return count;
+    }
+
+private:
+    struct PairKey {
+        EntityID a, b;
+
+        bool operator==(const PairKey &other) const {
+            return a == other.a && b == other.b;
+        }
+    };
+
+    struct PairKeyHash {
+        size_t operator()(const PairKey &key) const {
+            return std::hash<EntityID>()(key.a * 0x9E3779B97F4A7C15ull ^ key.b);
+        }
+    };
+
+    std::vector<ContactConstraint> m_constraints;
+    std::vector<ContactConstraint> m_previous;
+    std::unordered_map<PairKey, uint32_t, PairKeyHash> m_previousIndex;
+
+    // Colors used by the contacts of each body so far, one bit per color
+    std::vector<uint64_t> m_bodyColors;
+    std::vector<uint8_t> m_constraintColors;
+    // Contacts of color c are [m_colorOffsets[c], m_colorOffsets[c + 1])
+    std::vector<size_t> m_colorOffsets;
+    std::vector<size_t> m_colorStarts;
+    std::vector<ContactConstraint> m_scratch;
+
+    // Position and angle change of each body during solvePositions
+    struct PositionDelta {
+        glm::vec2 linear;
+        float angular;
+    };
+    std::vector<PositionDelta> m_positionDeltas;
+
+    SatKernels::Kind m_kernel = SatKernels::best();
+    // Rows of color c are [m_rowOffsets[c], m_rowOffsets[c + 1])
+    std::vector<ContactRows> m_rows;
+    std::vector<size_t> m_rowOffsets;
+
+    // Sorts the contacts by color, keeping their order inside a color
+    void colorConstraints(const RigidBodies &bodies);
+    // Packs every color but the overflow one into rows
+    void buildRows(const RigidBodies &bodies);
+    // Copies the impulses accumulated in the rows back to the contacts
+    void storeRowImpulses();
+};
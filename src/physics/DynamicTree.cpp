@@ -0,0 +1,313 @@
+#include "DynamicTree.h"
+
+#include <algorithm>
+#include <cassert>
+
+// Fat bounds add this fraction of the body size on every side
+static constexpr float FAT_MARGIN_RATIO = 0.1f;
+static constexpr float MIN_FAT_MARGIN = 0.001f;
+// How many steps of displacement the fat bounds look ahead
+static constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+
+static AABB combine(const AABB &a, const AABB &b) {
+    return { std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+}
+
+static float perimeter(const AABB &bounds) {
+    return 2.0f * ((bounds.maxX - bounds.minX) + (bounds.maxY - bounds.minY));
+}
+
+static bool contains(const AABB &outer, const AABB &inner) {
+    return outer.minX <= inner.minX && outer.minY <= inner.minY && inner.maxX <= outer.maxX && inner.maxY <= outer.maxY;
+}
+
+static AABB fatten(const AABB &bounds) {
+    float margin = std::max(FAT_MARGIN_RATIO * std::max(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY), MIN_FAT_MARGIN);
+    return { bounds.minX - margin, bounds.minY - margin, bounds.maxX + margin, bounds.maxY + margin };
+}
+
+int32_t DynamicTree::createProxy(const AABB &bounds, uint64_t userData) {
+    int32_t proxy = allocateNode();
+    m_nodes[proxy].bounds = fatten(bounds);
+    m_nodes[proxy].userData = userData;
+    m_nodes[proxy].height = 0;
+    insertLeaf(proxy);
+    m_proxyCount++;
+    return proxy;
+}
+
+void DynamicTree::destroyProxy(int32_t proxy) {
+    assert(m_nodes[proxy].isLeaf());
+    removeLeaf(proxy);
+    freeNode(proxy);
+    m_proxyCount--;
+}
+
+bool DynamicTree::moveProxy(int32_t proxy, const AABB &bounds, const glm::vec2 &displacement) {
+    assert(m_nodes[proxy].isLeaf());
+    if (contains(m_nodes[proxy].bounds, bounds)) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    AABB fat = fatten(bounds);
+    glm::vec2 ahead = displacement * DISPLACEMENT_MULTIPLIER;
+    if (ahead.x < 0.0f) {
+        fat.minX += ahead.x;
+    } else {
+        fat.maxX += ahead.x;
+    }
+    if (ahead.y < 0.0f) {
+        fat.minY += ahead.y;
+    } else {
+        fat.maxY += ahead.y;
+    }
+    m_nodes[proxy].bounds = fat;
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicTree::clear() {
+    m_nodes.clear();
+    m_root = NULL_NODE;
+    m_freeList = NULL_NODE;
+    m_proxyCount = 0;
+}
+
+bool DynamicTree::rayHitsBounds(const AABB &bounds, const glm::vec2 &origin, const glm::vec2 &direction, float maxDistance) {
+    // Slab test, a zero direction component only needs the origin inside that slab
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    const float minimums[2] = { bounds.minX, bounds.minY };
+    const float maximums[2] = { bounds.maxX, bounds.maxY };
+    for (int axis = 0; axis < 2; axis++) {
+        if (direction[axis] == 0.0f) {
+            if (origin[axis] < minimums[axis] || origin[axis] > maximums[axis]) {
+                return false;
+            }
+            continue;
+        }
+        float inverse = 1.0f / direction[axis];
+        float t1 = (minimums[axis] - origin[axis]) * inverse;
+        float t2 = (maximums[axis] - origin[axis]) * inverse;
+        tMin = std::max(tMin, std::min(t1, t2));
+        tMax = std::min(tMax, std::max(t1, t2));
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32_t DynamicTree::allocateNode() {
+    if (m_freeList == NULL_NODE) {
+        m_nodes.push_back(Node());
+        m_freeList = static_cast<int32_t>(m_nodes.size() - 1);
+        m_nodes[m_freeList].parent = NULL_NODE;
+    }
+    int32_t index = m_freeList;
+    m_freeList = m_nodes[index].parent;
+    m_nodes[index].parent = NULL_NODE;
+    m_nodes[index].child1 = NULL_NODE;
+    m_nodes[index].child2 = NULL_NODE;
+    m_nodes[index].height = 0;
+    m_nodes[index].userData = 0;
+    return index;
+}
+
+void DynamicTree::freeNode(int32_t index) {
+    m_nodes[index].parent = m_freeList;
+    m_nodes[index].height = -1;
+    m_freeList = index;
+}
+
+void DynamicTree::insertLeaf(int32_t leaf) {
+    if (m_root == NULL_NODE) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Walk down to the sibling that grows the total perimeter the least
+    AABB leafBounds = m_nodes[leaf].bounds;
+    int32_t index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const Node &node = m_nodes[index];
+        float combinedPerimeter = perimeter(combine(node.bounds, leafBounds));
+
+        // Cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedPerimeter;
+        // Every ancestor grows as well when the leaf goes further down
+        float inheritanceCost = 2.0f * (combinedPerimeter - perimeter(node.bounds));
+
+        auto descendCost = [&](int32_t child) {
+            float grown = perimeter(combine(leafBounds, m_nodes[child].bounds));
+            if (m_nodes[child].isLeaf()) {
+                return grown + inheritanceCost;
+            }
+            return grown - perimeter(m_nodes[child].bounds) + inheritanceCost;
+        };
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    int32_t sibling = index;
+    int32_t oldParent = m_nodes[sibling].parent;
+    int32_t newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].bounds = combine(leafBounds, m_nodes[sibling].bounds);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        m_root = newParent;
+    } else if (m_nodes[oldParent].child1 == sibling) {
+        m_nodes[oldParent].child1 = newParent;
+    } else {
+        m_nodes[oldParent].child2 = newParent;
+    }
+
+    // Refit and rebalance up to the root
+    index = m_nodes[leaf].parent;
+    while (index != NULL_NODE) {
+        index = balance(index);
+        Node &node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+        node.bounds = combine(m_nodes[node.child1].bounds, m_nodes[node.child2].bounds);
+        index = node.parent;
+    }
+}
+
+void DynamicTree::removeLeaf(int32_t leaf) {
+    if (leaf == m_root) {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = m_nodes[leaf].parent;
+    int32_t grandParent = m_nodes[parent].parent;
+    int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    // The sibling takes the place of the parent
+    freeNode(parent);
+    if (grandParent == NULL_NODE) {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        return;
+    }
+    if (m_nodes[grandParent].child1 == parent) {
+        m_nodes[grandParent].child1 = sibling;
+    } else {
+        m_nodes[grandParent].child2 = sibling;
+    }
+    m_nodes[sibling].parent = grandParent;
+
+    int32_t index = grandParent;
+    while (index != NULL_NODE) {
+        index = balance(index);
+        Node &node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+        node.bounds = combine(m_nodes[node.child1].bounds, m_nodes[node.child2].bounds);
+        index = node.parent;
+    }
+}
+
+int32_t DynamicTree::balance(int32_t indexA) {
+    Node &a = m_nodes[indexA];
+    if (a.isLeaf() || a.height < 2) {
+        return indexA;
+    }
+
+    int32_t indexB = a.child1;
+    int32_t indexC = a.child2;
+    Node &b = m_nodes[indexB];
+    Node &c = m_nodes[indexC];
+    int32_t heightDifference = c.height - b.height;
+
+    // C is too tall, it becomes the parent of A
+    if (heightDifference > 1) {
+        int32_t indexF = c.child1;
+        int32_t indexG = c.child2;
+        Node &f = m_nodes[indexF];
+        Node &g = m_nodes[indexG];
+
+        c.child1 = indexA;
+        c.parent = a.parent;
+        a.parent = indexC;
+        if (c.parent == NULL_NODE) {
+            m_root = indexC;
+        } else if (m_nodes[c.parent].child1 == indexA) {
+            m_nodes[c.parent].child1 = indexC;
+        } else {
+            m_nodes[c.parent].child2 = indexC;
+        }
+
+        // The taller grandchild stays under C
+        if (f.height > g.height) {
+            c.child2 = indexF;
+            a.child2 = indexG;
+            g.parent = indexA;
+            a.bounds = combine(b.bounds, g.bounds);
+            c.bounds = combine(a.bounds, f.bounds);
+            a.height = 1 + std::max(b.height, g.height);
+            c.height = 1 + std::max(a.height, f.height);
+        } else {
+            c.child2 = indexG;
+            a.child2 = indexF;
+            f.parent = indexA;
+            a.bounds = combine(b.bounds, f.bounds);
+            c.bounds = combine(a.bounds, g.bounds);
+            a.height = 1 + std::max(b.height, f.height);
+            c.height = 1 + std::max(a.height, g.height);
+        }
+        return indexC;
+    }
+
+    // B is too tall, it becomes the parent of A
+    if (heightDifference < -1) {
+        int32_t indexD = b.child1;
+        int32_t indexE = b.child2;
+        Node &d = m_nodes[indexD];
+        Node &e = m_nodes[indexE];
+
+        b.child1 = indexA;
+        b.parent = a.parent;
+        a.parent = indexB;
+        if (b.parent == NULL_NODE) {
+            m_root = indexB;
+        } else if (m_nodes[b.parent].child1 == indexA) {
+            m_nodes[b.parent].child1 = indexB;
+        } else {
+            m_nodes[b.parent].child2 = indexB;
+        }
+
+        if (d.height > e.height) {
+            b.child2 = indexD;
+            a.child1 = indexE;
+            e.parent = indexA;
+            a.bounds = combine(c.bounds, e.bounds);
+            b.bounds = combine(a.bounds, d.bounds);
+            a.height = 1 + std::max(c.height, e.height);
+            b.height = 1 + std::max(a.height, d.height);
+        } else {
+            b.child2 = indexE;
+            a.child1 = indexD;
+            d.parent = indexA;
+            a.bounds = combine(c.bounds, d.bounds);
+            b.bounds = combine(a.bounds, e.bounds);
+            a.height = 1 + std::max(c.height, d.height);
+            b.height = 1 + std::max(a.height, e.height);
+        }
+        return indexB;
+    }
+
+    return indexA;
+}
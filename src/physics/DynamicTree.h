@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "Broadphase.h"
+#include "glm/glm.hpp"
+
+// Bounding volume hierarchy over fattened AABBs, kept balanced with tree
+// rotations. Leaves only move when a body leaves its fat bounds, so bodies
+// at rest cost nothing per step, and queries visit O(log n) nodes.
+class DynamicTree {
+public:
+    static constexpr int32_t NULL_NODE = -1;
+    // Depth-first walks hold at most height + 1 nodes. Balancing keeps the
+    // height under 1.44 log2 of the node count, so this covers any tree an
+    // int32_t index can address and queries never allocate
+    static constexpr int32_t MAX_QUERY_STACK = 64;
+
+    // Inserts a leaf for bounds, padded by a margin, and returns its proxy
+    int32_t createProxy(const AABB &bounds, uint64_t userData);
+    void destroyProxy(int32_t proxy);
+    // Re-inserts the leaf only if bounds left its fat bounds. The new fat
+    // bounds are stretched along displacement to cover the next steps.
+    // Returns true when the leaf moved.
+    bool moveProxy(int32_t proxy, const AABB &bounds, const glm::vec2 &displacement);
+
+    uint64_t userData(int32_t proxy) const {
+        return m_nodes[proxy].userData;
+    }
+
+    void setUserData(int32_t proxy, uint64_t userData) {
+        m_nodes[proxy].userData = userData;
+    }
+
+    const AABB& fatBounds(int32_t proxy) const {
+        return m_nodes[proxy].bounds;
+    }
+
+    size_t proxyCount() const {
+        return m_proxyCount;
+    }
+
+    int32_t height() const {
+        return m_root == NULL_NODE ? 0 : m_nodes[m_root].height;
+    }
+
+    void clear();
+
+    // Calls fn(proxy) for every leaf whose fat bounds overlap bounds
+    template<typename Fn>
+    void query(const AABB &bounds, Fn&& fn) const {
+        if (m_root == NULL_NODE) {
+            return;
+        }
+        int32_t stack[MAX_QUERY_STACK];
+        int32_t count = 0;
+        stack[count++] = m_root;
+        while (count > 0) {
+            int32_t index = stack[--count];
+            const Node &node = m_nodes[index];
+            if (!node.bounds.overlaps(bounds)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                fn(index);
+            } else {
+                assert(count + 2 <= MAX_QUERY_STACK);
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+    // Calls fn(proxy) for every leaf
+    template<typename Fn>
+    void forEachProxy(Fn&& fn) const {
+        for (int32_t index = 0; index < static_cast<int32_t>(m_nodes.size()); index++) {
+            if (m_nodes[index].height == 0) {
+                fn(index);
+            }
+        }
+    }
+
+    // Walks the leaves whose fat bounds the ray origin + direction * t crosses
+    // for t in [0, maxDistance], direction being unit length. fn(proxy,
+    // maxDistance) returns the distance of an exact hit closer than
+    // maxDistance, or maxDistance itself, and the ray is clipped to it.
+    template<typename Fn>
+    void raycast(const glm::vec2 &origin, const glm::vec2 &direction, float maxDistance, Fn&& fn) const {
+        if (m_root == NULL_NODE) {
+            return;
+        }
+        int32_t stack[MAX_QUERY_STACK];
+        int32_t count = 0;
+        stack[count++] = m_root;
+        while (count > 0) {
+            int32_t index = stack[--count];
+            const Node &node = m_nodes[index];
+            if (!rayHitsBounds(node.bounds, origin, direction, maxDistance)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                maxDistance = fn(index, maxDistance);
+            } else {
+                assert(count + 2 <= MAX_QUERY_STACK);
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+private:
+    struct Node {
+        AABB bounds;
+        uint64_t userData;
+        // Next free node while the node is unused
+        int32_t parent;
+        int32_t child1, child2;
+        // Leaves are 0, free nodes -1
+        int32_t height;
+
+        bool isLeaf() const {
+            return child1 == NULL_NODE;
+        }
+    };
+
+    static bool rayHitsBounds(const AABB &bounds, const glm::vec2 &origin, const glm::vec2 &direction, float maxDistance);
+
+    int32_t allocateNode();
+    void freeNode(int32_t index);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    // Rotates the subtree at index if its children differ in height by more than one, returns the new subtree root
+    int32_t balance(int32_t index);
+
+    std::vector<Node> m_nodes;
+    int32_t m_root = NULL_NODE;
+    int32_t m_freeList = NULL_NODE;
+    size_t m_proxyCount = 0;
+};
@@ -1,26 +1,18 @@
 #include "Manifold.h"
 #include "../utils.h"
+#include <algorithm>
 #include <limits>
 #define GLM_ENABLE_EXPERIMENTAL
 
 #include "contacts.h"
+#include "SatKernels.h"
 #include "glm/gtx/norm.hpp"
 
-void Manifold::ApplyPositionalCorrection(glm::vec3& positionA, glm::vec3& positionB, float invMassA, float invMassB) const {
-    const float percent = 0.2f;
-    const float slop = 0.01f;
-    float totalInvMass = invMassA + invMassB;
-    glm::vec3 correction = std::max(penetration - slop, 0.0f) / totalInvMass * percent * normal;
-    positionA -= correction * invMassA;
-    positionB += correction * invMassB;
-}
-
 bool Manifold::CirclevsCircle(const glm::vec3 &centerA, float radiusA, const glm::vec3 &centerB, float radiusB) {
     glm::vec3 ab = centerB - centerA;
     float r = radiusA + radiusB;
 
-    r *= r;
-    if (glm::length2(ab) > r) return false;
+    if (glm::length2(ab) > r * r) return false;
 
     float d = glm::length(ab);
     penetration = r - d;
@@ -30,25 +22,51 @@ bool Manifold::CirclevsCircle(const glm::vec3 &centerA, float radiusA, const glm
     }
 
     contactPoint1 = contactPointCircleCircle(centerA, radiusA, centerB);
+    featureId1 = 0;
+    separation1 = -penetration;
     nContacts = 1;
     return true;
 }
 
-bool Manifold::CirclevsBox(const glm::vec3 &circleCenter, float circleRadius, const std::vector<glm::vec3> &boxVertices, const glm::vec3 &boxCenter) {
+// Vertices projected on an axis, Count is 0 when only known at runtime
+template<size_t Count>
+static void projectVertices(const ShapeVertices &vertices, const glm::vec3 &axis, float &min, float &max) {
+    size_t count = Count != 0 ? Count : vertices.size();
+    min = max = glm::dot(axis, vertices[0]);
+    for (size_t i = 1; i < count; i++) {
+        float projection = glm::dot(axis, vertices[i]);
+        min = std::min(min, projection);
+        max = std::max(max, projection);
+    }
+}
+
+// Edge normals worth testing: a box repeats its first two, negated, on the opposite edges
+template<size_t Count>
+static size_t separatingAxisCount(const ShapeVertices &normals) {
+    return Count == BOX_VERTICES ? 2 : normals.size();
+}
+
+bool Manifold::CirclevsBox(const glm::vec3 &circleCenter, float circleRadius, const ShapeVertices &boxVertices,
+    const ShapeVertices &boxNormals, const glm::vec3 &boxCenter) {
+    if (boxVertices.size() == BOX_VERTICES) {
+        return CirclevsPolygon<BOX_VERTICES>(circleCenter, circleRadius, boxVertices, boxNormals, boxCenter);
+    }
+    return CirclevsPolygon<0>(circleCenter, circleRadius, boxVertices, boxNormals, boxCenter);
+}
+
+template<size_t Count>
+bool Manifold::CirclevsPolygon(const glm::vec3 &circleCenter, float circleRadius, const ShapeVertices &boxVertices,
+    const ShapeVertices &boxNormals, const glm::vec3 &boxCenter) {
     normal = glm::vec3{};
     penetration = std::numeric_limits<float>::max();
     float minA, maxA;
     float minB, maxB;
 
-    for (int i = 0; i < boxVertices.size(); i++) {
-        glm::vec3 va = boxVertices[i];
-        glm::vec3 vb = boxVertices[(i + 1) % boxVertices.size()];
-
-        glm::vec3 edge = vb - va;
-        glm::vec3 axis = glm::vec3(-edge.y, edge.x, 0.0f);
-        axis = glm::normalize(axis);
+    size_t axisCount = separatingAxisCount<Count>(boxNormals);
+    for (size_t i = 0; i < axisCount; i++) {
+        const glm::vec3 &axis = boxNormals[i];
 
-        projectPolygon(boxVertices, axis, minA, maxA);
+        projectVertices<Count>(boxVertices, axis, minA, maxA);
         projectCircle(circleCenter, circleRadius, axis, minB, maxB);
 
         if (minA >= maxB || minB >= maxA) {
@@ -63,13 +81,13 @@ bool Manifold::CirclevsBox(const glm::vec3 &circleCenter, float circleRadius, co
         }
     }
 
-    int cpIndex = findClosestPointOnPolygon(circleCenter, boxVertices);
+    int cpIndex = findClosestPointOnPolygon<Count>(circleCenter, boxVertices);
     glm::vec3 cp = boxVertices[cpIndex];
 
     glm::vec3 axis = cp - circleCenter;
     axis = glm::normalize(axis);
 
-    projectPolygon(boxVertices, axis, minA, maxA);
+    projectVertices<Count>(boxVertices, axis, minA, maxA);
     projectCircle(circleCenter, circleRadius, axis, minB, maxB);
 
     if (minA >= maxB || minB >= maxA) {
@@ -92,62 +110,40 @@ bool Manifold::CirclevsBox(const glm::vec3 &circleCenter, float circleRadius, co
         normal = -normal;
     }
 
-    contactPoint1 = contactPointCirclevsBox(circleCenter, boxVertices);
+    contactPoint1 = contactPointCirclevsBox<Count>(circleCenter, boxVertices);
+    featureId1 = 0;
+    separation1 = -penetration;
     nContacts = 1;
 
     return true;
 }
 
-bool Manifold::BoxvsBox(const std::vector<glm::vec3> &boxVerticesA, const glm::vec3 &boxCenterA, const std::vector<glm::vec3> &boxVerticesB, const glm::vec3 &boxCenterB) {
-    normal = glm::vec3(1.0f);
-    penetration = std::numeric_limits<float>::max();
-
-    for (int i = 0; i < boxVerticesA.size(); i++) {
-        glm::vec3 va = boxVerticesA[i];
-        glm::vec3 vb = boxVerticesA[(i + 1) % boxVerticesA.size()];
-
-        glm::vec3 edge = vb - va;
-        glm::vec3 axis(-edge.y, edge.x, 0.0f);
-        axis = glm::normalize(axis);
-
-        float minA, maxA;
-        float minB, maxB;
-        projectPolygon(boxVerticesA, axis, minA, maxA);
-        projectPolygon(boxVerticesB, axis, minB, maxB);
-
-        if (minA >= maxB || minB >= maxA) {
-            return false;
-        }
-
-        float axisDepth = std::min(maxB - minA, maxA - minB);
-        if (axisDepth < penetration) {
-            penetration = axisDepth;
-            normal = axis;
-        }
+bool Manifold::BoxvsBox(const ShapeVertices &boxVerticesA, const ShapeVertices &boxNormalsA, const glm::vec3 &boxCenterA,
+    const ShapeVertices &boxVerticesB, const ShapeVertices &boxNormalsB, const glm::vec3 &boxCenterB) {
+    if (boxVerticesA.size() == BOX_VERTICES && boxVerticesB.size() == BOX_VERTICES) {
+        return PolygonvsPolygon<BOX_VERTICES, BOX_VERTICES>(boxVerticesA, boxNormalsA, boxCenterA, boxVerticesB, boxNormalsB, boxCenterB);
     }
-    for (int i = 0; i < boxVerticesB.size(); i++) {
-        glm::vec3 va = boxVerticesB[i];
-        glm::vec3 vb = boxVerticesB[(i + 1) % boxVerticesB.size()];
-
-        glm::vec3 edge = vb - va;
-        glm::vec3 axis(-edge.y, edge.x, 0.0f);
-        axis = glm::normalize(axis);
-
-        float minA, maxA;
-        float minB, maxB;
-        projectPolygon(boxVerticesA, axis, minA, maxA);
-        projectPolygon(boxVerticesB, axis, minB, maxB);
+    return PolygonvsPolygon<0, 0>(boxVerticesA, boxNormalsA, boxCenterA, boxVerticesB, boxNormalsB, boxCenterB);
+}
 
-        if (minA >= maxB || minB >= maxA) {
-            return false;
-        }
+template<size_t CountA, size_t CountB>
+bool Manifold::PolygonvsPolygon(const ShapeVertices &boxVerticesA, const ShapeVertices &boxNormalsA, const glm::vec3 &boxCenterA,
+    const ShapeVertices &boxVerticesB, const ShapeVertices &boxNormalsB, const glm::vec3 &boxCenterB) {
+    // Candidate axes of both boxes, tested together by the selected SAT kernel
+    glm::vec3 axes[SatKernels::MAX_AXES];
+    size_t axisCount = 0;
+    for (size_t i = 0; i < separatingAxisCount<CountA>(boxNormalsA); i++) {
+        axes[axisCount++] = boxNormalsA[i];
+    }
+    for (size_t i = 0; i < separatingAxisCount<CountB>(boxNormalsB); i++) {
+        axes[axisCount++] = boxNormalsB[i];
+    }
 
-        float axisDepth = std::min(maxB - minA, maxA - minB);
-        if (axisDepth < penetration) {
-            penetration = axisDepth;
-            normal = axis;
-        }
+    size_t axis = 0;
+    if (!SatKernels::findMinimumOverlap(axes, axisCount, boxVerticesA, boxVerticesB, axis, penetration)) {
+        return false;
     }
+    normal = axes[axis];
 
     penetration /= glm::length(normal);
     normal = glm::normalize(normal);
@@ -158,13 +154,15 @@ bool Manifold::BoxvsBox(const std::vector<glm::vec3> &boxVerticesA, const glm::v
         normal = -normal;
     }
 
-    ContactPoints contactPoints = contactPointsBoxBox(boxVerticesA, boxVerticesB);
+    ContactPoints contactPoints = contactPointsBoxBox<CountA, CountB>(boxVerticesA, boxNormalsA, boxVerticesB, boxNormalsB, normal);
 
     contactPoint1 = contactPoints.contact1;
     contactPoint2 = contactPoints.contact2;
+    featureId1 = contactPoints.feature1;
+    featureId2 = contactPoints.feature2;
+    separation1 = contactPoints.separation1;
+    separation2 = contactPoints.separation2;
     nContacts = contactPoints.nContacts;
 
     return true;
 }
-
-
@@ -1,19 +1,41 @@
 #ifndef MANIFOLD_H
 #define MANIFOLD_H
+#include <cstdint>
+
 #include "glm/vec3.hpp"
-#include <vector>
+#include "ShapeVertices.h"
 
 struct Manifold {
     glm::vec3 normal;
     float penetration;
     glm::vec3 contactPoint1;
     glm::vec3 contactPoint2;
+    // Feature of each contact point, lets the solver match it with the previous step. Circle contacts are 0
+    uint32_t featureId1;
+    uint32_t featureId2;
+    // Signed distance at each contact point along the normal, negative while
+    // overlapping. Circle contacts have -penetration
+    float separation1;
+    float separation2;
     int nContacts;
 
-    void ApplyPositionalCorrection(glm::vec3& positionA, glm::vec3& positionB, float invMassA, float invMassB) const;
     bool CirclevsCircle(const glm::vec3 &centerA, float radiusA, const glm::vec3 &centerB, float radiusB);
-    bool BoxvsBox(const std::vector<glm::vec3> &boxVerticesA, const glm::vec3 &boxCenterA, const std::vector<glm::vec3> &boxVerticesB, const glm::vec3 &boxCenterB);
-    bool CirclevsBox(const glm::vec3 &circleCenter, float circleRadius, const std::vector<glm::vec3> &boxVertices, const glm::vec3 &boxCenter);
+    // Box normals are the unit edge normals from Transformations::computeEdgeNormals.
+    // Boxes with BOX_VERTICES vertices take an unrolled path that only tests
+    // two axes per box, opposite edges of a rectangle sharing their axis.
+    bool BoxvsBox(const ShapeVertices &boxVerticesA, const ShapeVertices &boxNormalsA, const glm::vec3 &boxCenterA,
+        const ShapeVertices &boxVerticesB, const ShapeVertices &boxNormalsB, const glm::vec3 &boxCenterB);
+    bool CirclevsBox(const glm::vec3 &circleCenter, float circleRadius, const ShapeVertices &boxVertices,
+        const ShapeVertices &boxNormals, const glm::vec3 &boxCenter);
+
+private:
+    // Count is the vertex count of every shape, or 0 to read it at runtime
+    template<size_t CountA, size_t CountB>
+    bool PolygonvsPolygon(const ShapeVertices &verticesA, const ShapeVertices &normalsA, const glm::vec3 &centerA,
+        const ShapeVertices &verticesB, const ShapeVertices &normalsB, const glm::vec3 &centerB);
+    template<size_t Count>
+    bool CirclevsPolygon(const glm::vec3 &circleCenter, float circleRadius, const ShapeVertices &vertices,
+        const ShapeVertices &normals, const glm::vec3 &center);
 };
 
 #endif
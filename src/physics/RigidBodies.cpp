@@ -0,0 +1,96 @@
+#include "RigidBodies.h"
+
+uint32_t RigidBodies::add(EntityID owner, const RigidBodyState &state) {
+    uint32_t body = static_cast<uint32_t>(owners.size());
+    forEachArray([](BodyArray &array) {
+        array.emplace_back();
+    });
+    owners.push_back(owner);
+    treeProxies.push_back(-1);
+    sleepIsland.emplace_back();
+    write(body, state);
+    return body;
+}
+
+void RigidBodies::write(uint32_t body, const RigidBodyState &state) {
+    x[body] = state.x;
+    y[body] = state.y;
+    vx[body] = state.vx;
+    vy[body] = state.vy;
+    angle[body] = state.angle;
+    omega[body] = state.omega;
+    invMass[body] = state.invMass;
+    invInertia[body] = state.invInertia;
+    ax[body] = state.ax;
+    ay[body] = state.ay;
+    angularAcceleration[body] = state.angularAcceleration;
+    staticFriction[body] = state.staticFriction;
+    dynamicFriction[body] = state.dynamicFriction;
+    restitution[body] = state.restitution;
+    sleepTime[body] = state.sleepTime;
+    sleepIsland[body] = state.sleepIsland;
+    previousX[body] = state.x;
+    previousY[body] = state.y;
+    previousAngle[body] = state.angle;
+}
+
+void RigidBodies::reserve(size_t count) {
+    forEachArray([&](BodyArray &array) {
+        array.reserve(count);
+    });
+    owners.reserve(count);
+    treeProxies.reserve(count);
+    sleepIsland.reserve(count);
+}
+
+EntityID RigidBodies::remove(uint32_t body) {
+    size_t last = owners.size() - 1;
+    forEachArray([&](BodyArray &array) {
+        array[body] = array[last];
+        array.pop_back();
+    });
+    owners[body] = owners[last];
+    owners.pop_back();
+    treeProxies[body] = treeProxies[last];
+    treeProxies.pop_back();
+    sleepIsland[body] = sleepIsland[last];
+    sleepIsland.pop_back();
+    return body < owners.size() ? owners[body] : EntityID(-1);
+}
+
+void RigidBodies::permute(const std::vector<uint32_t> &order) {
+    BodyArray scratch(order.size());
+    forEachArray([&](BodyArray &array) {
+        for (size_t i = 0; i < order.size(); i++) {
+            scratch[i] = array[order[i]];
+        }
+        array.swap(scratch);
+    });
+
+    std::vector<EntityID> ownerScratch(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        ownerScratch[i] = owners[order[i]];
+    }
+    owners.swap(ownerScratch);
+
+    std::vector<int32_t> proxyScratch(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        proxyScratch[i] = treeProxies[order[i]];
+    }
+    treeProxies.swap(proxyScratch);
+
+    std::vector<uint32_t> islandScratch(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        islandScratch[i] = sleepIsland[order[i]];
+    }
+    sleepIsland.swap(islandScratch);
+}
+
+void RigidBodies::clear() {
+    forEachArray([](BodyArray &array) {
+        array.clear();
+    });
+    owners.clear();
+    treeProxies.clear();
+    sleepIsland.clear();
+}
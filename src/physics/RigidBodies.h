@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "../Entity.h"
+
+// std::allocator only guarantees alignof(T), SIMD loops want whole cache lines
+template<typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float, 64>> BodyArray;
+
+// One body as a plain struct, to seed or read a slot of RigidBodies
+struct RigidBodyState {
+    float x = 0.0f, y = 0.0f;
+    float vx = 0.0f, vy = 0.0f;
+    float angle = 0.0f, omega = 0.0f;
+    float invMass = 0.0f, invInertia = 0.0f;
+    float ax = 0.0f, ay = 0.0f;
+    float angularAcceleration = 0.0f;
+    float staticFriction = 0.0f, dynamicFriction = 0.0f;
+    float restitution = 0.0f;
+    float sleepTime = 0.0f;
+    uint32_t sleepIsland = 0;
+};
+
+// Structure-of-arrays storage for every rigid body of a scene, packed with no
+// holes. Entities point at their slot through RigidBodyComponent. Hot arrays
+// are read and written by integration and collision response every step,
+// cold arrays are inputs that rarely change.
+struct RigidBodies {
+    static constexpr uint32_t NO_BODY = std::numeric_limits<uint32_t>::max();
+
+    // Hot
+    BodyArray x, y;
+    BodyArray vx, vy;
+    BodyArray angle, omega;
+    BodyArray invMass, invInertia;
+
+    // Cold
+    BodyArray ax, ay;
+    BodyArray angularAcceleration;
+    BodyArray staticFriction, dynamicFriction;
+    BodyArray restitution;
+    // Seconds the body has been nearly still
+    BodyArray sleepTime;
+    // Pose at the start of the last fixed step taken by World::advance, to draw between steps
+    BodyArray previousX, previousY, previousAngle;
+
+    // Entity owning each body
+    std::vector<EntityID> owners;
+    // Leaf of each body in the World's query tree, -1 until a step indexes it
+    std::vector<int32_t> treeProxies;
+    // Island the body sleeps in, 0 while awake
+    std::vector<uint32_t> sleepIsland;
+
+    size_t size() const {
+        return owners.size();
+    }
+
+    // Static bodies can neither move nor turn, contacts only read them
+    bool isStatic(uint32_t body) const {
+        return invMass[body] == 0.0f && invInertia[body] == 0.0f;
+    }
+
+    // Calls fn(BodyArray&) for every per-body float array, hot ones first
+    template<typename Fn>
+    void forEachArray(Fn&& fn) {
+        BodyArray* arrays[] = { &x, &y, &vx, &vy, &angle, &omega, &invMass, &invInertia,
+            &ax, &ay, &angularAcceleration, &staticFriction, &dynamicFriction, &restitution, &sleepTime,
+            &previousX, &previousY, &previousAngle };
+        for (BodyArray *array : arrays) {
+            fn(*array);
+        }
+    }
+
+    template<typename Fn>
+    void forEachArray(Fn&& fn) const {
+        const BodyArray* arrays[] = { &x, &y, &vx, &vy, &angle, &omega, &invMass, &invInertia,
+            &ax, &ay, &angularAcceleration, &staticFriction, &dynamicFriction, &restitution, &sleepTime,
+            &previousX, &previousY, &previousAngle };
+        for (const BodyArray *array : arrays) {
+            fn(*array);
+        }
+    }
+
+    // Appends a zeroed body and returns its slot
+    uint32_t add(EntityID owner) {
+        return add(owner, RigidBodyState());
+    }
+
+    uint32_t add(EntityID owner, const RigidBodyState &state);
+
+    // Overwrites every field of the body, its previous pose included
+    void write(uint32_t body, const RigidBodyState &state);
+
+    void reserve(size_t count);
+
+    // Fills the slot with the last body to keep the arrays packed. Returns the
+    // owner of the body that moved into the slot, EntityID(-1) if it was the last one
+    EntityID remove(uint32_t body);
+
+    // Reorders every array so that slot i takes the body at order[i]
+    void permute(const std::vector<uint32_t> &order);
+
+    void clear();
+};
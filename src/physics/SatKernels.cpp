@@ -0,0 +1,245 @@
+#include "SatKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAT_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled per function with a target attribute and picked at runtime,
+// so the rest of the build keeps the baseline instruction set
+#if defined(SAT_HAS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SAT_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+std::atomic<SatKernels::Kind> s_selected{ SatKernels::best() };
+
+// Reference kernel, one vertex on one axis at a time
+void projectScalar(const ShapeVertices &vertices, const glm::vec3 &axis, float &min, float &max) {
+    min = max = glm::dot(axis, vertices[0]);
+    for (size_t i = 1; i < vertices.size(); i++) {
+        float projection = glm::dot(axis, vertices[i]);
+        min = std::min(min, projection);
+        max = std::max(max, projection);
+    }
+}
+
+bool findMinimumOverlapScalar(const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+    const ShapeVertices &verticesB, size_t &axis, float &depth) {
+    depth = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < axisCount; i++) {
+        float minA, maxA;
+        float minB, maxB;
+        projectScalar(verticesA, axes[i], minA, maxA);
+        projectScalar(verticesB, axes[i], minB, maxB);
+
+        if (minA >= maxB || minB >= maxA) {
+            return false;
+        }
+
+        float axisDepth = std::min(maxB - minA, maxA - minB);
+        if (axisDepth < depth) {
+            depth = axisDepth;
+            axis = i;
+        }
+    }
+    return true;
+}
+
+// Axes split into x, y and z arrays for the SIMD kernels. Lanes past
+// axisCount repeat axis 0, which cannot change the outcome
+struct AxisLanes {
+    alignas(32) float x[SatKernels::MAX_AXES];
+    alignas(32) float y[SatKernels::MAX_AXES];
+    alignas(32) float z[SatKernels::MAX_AXES];
+
+    AxisLanes(const glm::vec3 *axes, size_t axisCount) {
+        for (size_t i = 0; i < SatKernels::MAX_AXES; i++) {
+            const glm::vec3 &axis = axes[i < axisCount ? i : 0];
+            x[i] = axis.x;
+            y[i] = axis.y;
+            z[i] = axis.z;
+        }
+    }
+};
+
+// Keeps the first smallest overlap of a batch, like the scalar loop
+void pickMinimum(const float *depths, size_t first, size_t laneCount, size_t &axis, float &depth) {
+    for (size_t lane = 0; lane < laneCount; lane++) {
+        if (depths[lane] < depth) {
+            depth = depths[lane];
+            axis = first + lane;
+        }
+    }
+}
+
+#ifdef SAT_HAS_SSE2
+// The dot product adds x, y and z in the order glm::dot does, so projections round the same.
+// Operand order of min and max matches std::min and std::max
+__m128 dotSse(const glm::vec3 &vertex, __m128 x, __m128 y, __m128 z) {
+    __m128 xy = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(vertex.x)), _mm_mul_ps(y, _mm_set1_ps(vertex.y)));
+    return _mm_add_ps(xy, _mm_mul_ps(z, _mm_set1_ps(vertex.z)));
+}
+
+void projectSse(const ShapeVertices &vertices, __m128 x, __m128 y, __m128 z, __m128 &min, __m128 &max) {
+    min = max = dotSse(vertices[0], x, y, z);
+    for (size_t i = 1; i < vertices.size(); i++) {
+        __m128 projection = dotSse(vertices[i], x, y, z);
+        min = _mm_min_ps(projection, min);
+        max = _mm_max_ps(projection, max);
+    }
+}
+
+bool findMinimumOverlapSse2(const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+    const ShapeVertices &verticesB, size_t &axis, float &depth) {
+    AxisLanes lanes(axes, axisCount);
+    depth = std::numeric_limits<float>::max();
+    for (size_t first = 0; first < axisCount; first += 4) {
+        __m128 x = _mm_load_ps(lanes.x + first);
+        __m128 y = _mm_load_ps(lanes.y + first);
+        __m128 z = _mm_load_ps(lanes.z + first);
+        __m128 minA, maxA, minB, maxB;
+        projectSse(verticesA, x, y, z, minA, maxA);
+        projectSse(verticesB, x, y, z, minB, maxB);
+
+        __m128 separated = _mm_or_ps(_mm_cmpge_ps(minA, maxB), _mm_cmpge_ps(minB, maxA));
+        if (_mm_movemask_ps(separated) != 0) {
+            return false;
+        }
+
+        alignas(16) float depths[4];
+        _mm_store_ps(depths, _mm_min_ps(_mm_sub_ps(maxA, minB), _mm_sub_ps(maxB, minA)));
+        pickMinimum(depths, first, std::min<size_t>(4, axisCount - first), axis, depth);
+    }
+    return true;
+}
+#endif
+
+#ifdef SAT_HAS_AVX2
+__attribute__((target("avx2")))
+__m256 dotAvx(const glm::vec3 &vertex, __m256 x, __m256 y, __m256 z) {
+    __m256 xy = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(vertex.x)), _mm256_mul_ps(y, _mm256_set1_ps(vertex.y)));
+    return _mm256_add_ps(xy, _mm256_mul_ps(z, _mm256_set1_ps(vertex.z)));
+}
+
+__attribute__((target("avx2")))
+void projectAvx(const ShapeVertices &vertices, __m256 x, __m256 y, __m256 z, __m256 &min, __m256 &max) {
+    min = max = dotAvx(vertices[0], x, y, z);
+    for (size_t i = 1; i < vertices.size(); i++) {
+        __m256 projection = dotAvx(vertices[i], x, y, z);
+        min = _mm256_min_ps(projection, min);
+        max = _mm256_max_ps(projection, max);
+    }
+}
+
+__attribute__((target("avx2")))
+bool findMinimumOverlapAvx2(const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+    const ShapeVertices &verticesB, size_t &axis, float &depth) {
+    AxisLanes lanes(axes, axisCount);
+    depth = std::numeric_limits<float>::max();
+    for (size_t first = 0; first < axisCount; first += 8) {
+        __m256 x = _mm256_load_ps(lanes.x + first);
+        __m256 y = _mm256_load_ps(lanes.y + first);
+        __m256 z = _mm256_load_ps(lanes.z + first);
+        __m256 minA, maxA, minB, maxB;
+        projectAvx(verticesA, x, y, z, minA, maxA);
+        projectAvx(verticesB, x, y, z, minB, maxB);
+
+        __m256 separated = _mm256_or_ps(_mm256_cmp_ps(minA, maxB, _CMP_GE_OQ), _mm256_cmp_ps(minB, maxA, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(separated) != 0) {
+            return false;
+        }
+
+        alignas(32) float depths[8];
+        _mm256_store_ps(depths, _mm256_min_ps(_mm256_sub_ps(maxA, minB), _mm256_sub_ps(maxB, minA)));
+        pickMinimum(depths, first, std::min<size_t>(8, axisCount - first), axis, depth);
+    }
+    return true;
+}
+#endif
+
+}
+
+bool SatKernels::supported(Kind kind) {
+    switch (kind) {
+    case Kind::Scalar:
+        return true;
+    case Kind::SSE2:
+#ifdef SAT_HAS_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case Kind::AVX2:
+#ifdef SAT_HAS_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+SatKernels::Kind SatKernels::best() {
+    if (supported(Kind::AVX2)) {
+        return Kind::AVX2;
+    }
+    if (supported(Kind::SSE2)) {
+        return Kind::SSE2;
+    }
+    return Kind::Scalar;
+}
+
+const char* SatKernels::name(Kind kind) {
+    switch (kind) {
+    case Kind::Scalar:
+        return "scalar";
+    case Kind::SSE2:
+        return "sse2";
+    case Kind::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+bool SatKernels::select(Kind kind) {
+    if (!supported(kind)) {
+        return false;
+    }
+    s_selected.store(kind, std::memory_order_relaxed);
+    return true;
+}
+
+SatKernels::Kind SatKernels::selected() {
+    return s_selected.load(std::memory_order_relaxed);
+}
+
+bool SatKernels::findMinimumOverlap(const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+    const ShapeVertices &verticesB, size_t &axis, float &depth) {
+    return findMinimumOverlap(selected(), axes, axisCount, verticesA, verticesB, axis, depth);
+}
+
+bool SatKernels::findMinimumOverlap(Kind kind, const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+    const ShapeVertices &verticesB, size_t &axis, float &depth) {
+    assert(axisCount <= MAX_AXES && !verticesA.empty() && !verticesB.empty());
+    switch (kind) {
+#ifdef SAT_HAS_AVX2
+    case Kind::AVX2:
+        return findMinimumOverlapAvx2(axes, axisCount, verticesA, verticesB, axis, depth);
+#endif
+#ifdef SAT_HAS_SSE2
+    case Kind::SSE2:
+        return findMinimumOverlapSse2(axes, axisCount, verticesA, verticesB, axis, depth);
+#endif
+    default:
+        return findMinimumOverlapScalar(axes, axisCount, verticesA, verticesB, axis, depth);
+    }
+}
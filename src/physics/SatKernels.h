@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include "glm/glm.hpp"
+#include "ShapeVertices.h"
+
+// Separating axis test of two convex polygons over a set of candidate axes.
+// The SIMD kernels project every vertex on several axes at once and keep a
+// running min/max per axis, so no horizontal reduction is needed until the
+// end of a batch. All kernels round exactly like the scalar one.
+namespace SatKernels {
+    enum class Kind {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Edge normals of both polygons
+    constexpr size_t MAX_AXES = 2 * MAX_POLYGON_VERTICES;
+
+    // False when this build or CPU cannot run the kernel
+    bool supported(Kind kind);
+    // Widest supported kernel, the one selected at startup
+    Kind best();
+    const char* name(Kind kind);
+
+    // Kernel used by findMinimumOverlap, shared by every world in the process.
+    // Returns false, keeping the current one, when kind is not supported
+    bool select(Kind kind);
+    Kind selected();
+
+    // Projects both polygons on axes[0, axisCount). Returns false if one of
+    // the axes separates them, otherwise axis is the index of the smallest
+    // overlap, the first one on ties, and depth that overlap
+    bool findMinimumOverlap(const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+        const ShapeVertices &verticesB, size_t &axis, float &depth);
+    // Same with an explicit kernel, which must be supported
+    bool findMinimumOverlap(Kind kind, const glm::vec3 *axes, size_t axisCount, const ShapeVertices &verticesA,
+        const ShapeVertices &verticesB, size_t &axis, float &depth);
+}
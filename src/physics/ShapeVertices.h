@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "glm/glm.hpp"
+
+// Vector-like storage for up to N elements kept inline, so a component that
+// holds one needs no heap allocation and stays trivially copyable
+template<typename T, size_t N>
+class InlineVector {
+    static_assert(std::is_trivially_copyable_v<T>, "InlineVector elements are copied as raw bytes");
+
+public:
+    static constexpr size_t capacity() { return N; }
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+
+    T* data() { return m_items.data(); }
+    const T* data() const { return m_items.data(); }
+    T* begin() { return m_items.data(); }
+    T* end() { return m_items.data() + m_count; }
+    const T* begin() const { return m_items.data(); }
+    const T* end() const { return m_items.data() + m_count; }
+
+    T& operator[](size_t index) {
+        assert(index < m_count);
+        return m_items[index];
+    }
+
+    const T& operator[](size_t index) const {
+        assert(index < m_count);
+        return m_items[index];
+    }
+
+    void push_back(const T &value) {
+        assert(m_count < N);
+        m_items[m_count++] = value;
+    }
+
+    void clear() {
+        m_count = 0;
+    }
+
+    template<typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+private:
+    std::array<T, N> m_items{};
+    uint32_t m_count = 0;
+};
+
+// Most vertices a shape may have
+constexpr size_t MAX_POLYGON_VERTICES = 8;
+// Box shapes always have this many, laid out as a rectangle
+constexpr size_t BOX_VERTICES = 4;
+
+using ShapeVertices = InlineVector<glm::vec3, MAX_POLYGON_VERTICES>;
@@ -0,0 +1,414 @@
+#include "SolverKernels.h"
+
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOLVER_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled per function with a target attribute and picked at runtime,
+// so the rest of the build keeps the baseline instruction set
+#if defined(SOLVER_HAS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SOLVER_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+#ifdef SOLVER_HAS_SSE2
+constexpr size_t SSE_LANES = 4;
+
+struct VelocitiesSse {
+    __m128 vx, vy, omega;
+};
+
+__m128 maskSse(const uint32_t *mask) {
+    return _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(mask)));
+}
+
+// a where mask is set, b elsewhere
+__m128 selectSse(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+VelocitiesSse gatherSse(const RigidBodies &bodies, const uint32_t *index) {
+    alignas(16) float vx[SSE_LANES], vy[SSE_LANES], omega[SSE_LANES];
+    for (size_t lane = 0; lane < SSE_LANES; lane++) {
+        vx[lane] = bodies.vx[index[lane]];
+        vy[lane] = bodies.vy[index[lane]];
+        omega[lane] = bodies.omega[index[lane]];
+    }
+    return { _mm_load_ps(vx), _mm_load_ps(vy), _mm_load_ps(omega) };
+}
+
+void scatterSse(RigidBodies &bodies, const uint32_t *index, const uint32_t *moves, const VelocitiesSse &velocities) {
+    alignas(16) float vx[SSE_LANES], vy[SSE_LANES], omega[SSE_LANES];
+    _mm_store_ps(vx, velocities.vx);
+    _mm_store_ps(vy, velocities.vy);
+    _mm_store_ps(omega, velocities.omega);
+    for (size_t lane = 0; lane < SSE_LANES; lane++) {
+        if (moves[lane] != 0) {
+            bodies.vx[index[lane]] = vx[lane];
+            bodies.vy[index[lane]] = vy[lane];
+            bodies.omega[index[lane]] = omega[lane];
+        }
+    }
+}
+
+// Speed of the points on B relative to the ones on A along the direction
+__m128 relativeSpeedSse(const VelocitiesSse &a, const VelocitiesSse &b, const ContactRows::Point &point, size_t first,
+    __m128 directionX, __m128 directionY) {
+    __m128 x = _mm_sub_ps(_mm_add_ps(b.vx, _mm_mul_ps(b.omega, _mm_load_ps(point.perpBX + first))),
+        _mm_add_ps(a.vx, _mm_mul_ps(a.omega, _mm_load_ps(point.perpAX + first))));
+    __m128 y = _mm_sub_ps(_mm_add_ps(b.vy, _mm_mul_ps(b.omega, _mm_load_ps(point.perpBY + first))),
+        _mm_add_ps(a.vy, _mm_mul_ps(a.omega, _mm_load_ps(point.perpAY + first))));
+    return _mm_add_ps(_mm_mul_ps(x, directionX), _mm_mul_ps(y, directionY));
+}
+
+void applyImpulseSse(VelocitiesSse &a, VelocitiesSse &b, const ContactRows &rows, const ContactRows::Point &point, size_t first,
+    __m128 active, __m128 impulseX, __m128 impulseY) {
+    __m128 movesA = _mm_and_ps(active, maskSse(rows.movesA + first));
+    __m128 invMassA = _mm_load_ps(rows.invMassA + first);
+    __m128 crossA = _mm_add_ps(_mm_mul_ps(_mm_load_ps(point.perpAX + first), impulseX),
+        _mm_mul_ps(_mm_load_ps(point.perpAY + first), impulseY));
+    a.vx = selectSse(movesA, _mm_sub_ps(a.vx, _mm_mul_ps(impulseX, invMassA)), a.vx);
+    a.vy = selectSse(movesA, _mm_sub_ps(a.vy, _mm_mul_ps(impulseY, invMassA)), a.vy);
+    a.omega = selectSse(movesA, _mm_sub_ps(a.omega, _mm_mul_ps(crossA, _mm_load_ps(rows.invInertiaA + first))), a.omega);
+
+    __m128 movesB = _mm_and_ps(active, maskSse(rows.movesB + first));
+    __m128 invMassB = _mm_load_ps(rows.invMassB + first);
+    __m128 crossB = _mm_add_ps(_mm_mul_ps(_mm_load_ps(point.perpBX + first), impulseX),
+        _mm_mul_ps(_mm_load_ps(point.perpBY + first), impulseY));
+    b.vx = selectSse(movesB, _mm_add_ps(b.vx, _mm_mul_ps(impulseX, invMassB)), b.vx);
+    b.vy = selectSse(movesB, _mm_add_ps(b.vy, _mm_mul_ps(impulseY, invMassB)), b.vy);
+    b.omega = selectSse(movesB, _mm_add_ps(b.omega, _mm_mul_ps(crossB, _mm_load_ps(rows.invInertiaB + first))), b.omega);
+}
+
+void warmStartPointSse(VelocitiesSse &a, VelocitiesSse &b, const ContactRows &rows, const ContactRows::Point &point, size_t first) {
+    __m128 normalImpulse = _mm_load_ps(point.normalImpulse + first);
+    __m128 tangentImpulse = _mm_load_ps(point.tangentImpulse + first);
+    __m128 impulseX = _mm_add_ps(_mm_mul_ps(normalImpulse, _mm_load_ps(rows.normalX + first)),
+        _mm_mul_ps(tangentImpulse, _mm_load_ps(rows.tangentX + first)));
+    __m128 impulseY = _mm_add_ps(_mm_mul_ps(normalImpulse, _mm_load_ps(rows.normalY + first)),
+        _mm_mul_ps(tangentImpulse, _mm_load_ps(rows.tangentY + first)));
+    applyImpulseSse(a, b, rows, point, first, maskSse(point.active + first), impulseX, impulseY);
+}
+
+void solveFrictionSse(VelocitiesSse &a, VelocitiesSse &b, const ContactRows &rows, ContactRows::Point &point, size_t first) {
+    __m128 active = maskSse(point.active + first);
+    __m128 tangentX = _mm_load_ps(rows.tangentX + first);
+    __m128 tangentY = _mm_load_ps(rows.tangentY + first);
+    __m128 normalImpulse = _mm_load_ps(point.normalImpulse + first);
+    __m128 tangentImpulse = _mm_load_ps(point.tangentImpulse + first);
+    __m128 sign = _mm_set1_ps(-0.0f);
+
+    // Friction, clamped like std::clamp once past static friction
+    __m128 tangentSpeed = relativeSpeedSse(a, b, point, first, tangentX, tangentY);
+    __m128 tangent = _mm_sub_ps(tangentImpulse, _mm_mul_ps(_mm_load_ps(point.tangentMass + first), tangentSpeed));
+    __m128 sliding = _mm_cmpgt_ps(_mm_andnot_ps(sign, tangent), _mm_mul_ps(_mm_load_ps(rows.staticFriction + first), normalImpulse));
+    __m128 limit = _mm_mul_ps(_mm_load_ps(rows.dynamicFriction + first), normalImpulse);
+    __m128 lowest = _mm_xor_ps(sign, limit);
+    __m128 clamped = selectSse(_mm_cmplt_ps(tangent, lowest), lowest, selectSse(_mm_cmplt_ps(limit, tangent), limit, tangent));
+    tangent = selectSse(sliding, clamped, tangent);
+    __m128 tangentDelta = _mm_sub_ps(tangent, tangentImpulse);
+    applyImpulseSse(a, b, rows, point, first, active, _mm_mul_ps(tangentDelta, tangentX), _mm_mul_ps(tangentDelta, tangentY));
+    _mm_store_ps(point.tangentImpulse + first, tangent);
+}
+
+// Normal impulses, the single point update where a lane has one point and
+// the cases of ContactSolver's block solve, in its order, where it has two
+void solveNormalsSse(VelocitiesSse &a, VelocitiesSse &b, ContactRows &rows, size_t first) {
+    ContactRows::Point &point1 = rows.points[0];
+    ContactRows::Point &point2 = rows.points[1];
+    __m128 normalX = _mm_load_ps(rows.normalX + first);
+    __m128 normalY = _mm_load_ps(rows.normalY + first);
+    __m128 old1 = _mm_load_ps(point1.normalImpulse + first);
+    __m128 old2 = _mm_load_ps(point2.normalImpulse + first);
+    __m128 mass1 = _mm_load_ps(point1.normalMass + first);
+    __m128 mass2 = _mm_load_ps(point2.normalMass + first);
+    __m128 bias1 = _mm_load_ps(point1.velocityBias + first);
+    __m128 bias2 = _mm_load_ps(point2.velocityBias + first);
+    __m128 speed1 = relativeSpeedSse(a, b, point1, first, normalX, normalY);
+    __m128 speed2 = relativeSpeedSse(a, b, point2, first, normalX, normalY);
+    __m128 zero = _mm_setzero_ps();
+    __m128 sign = _mm_set1_ps(-0.0f);
+
+    // Operand order of max matches std::max(x, 0.0f)
+    __m128 single = _mm_max_ps(zero, _mm_add_ps(old1, _mm_mul_ps(mass1, _mm_sub_ps(bias1, speed1))));
+
+    __m128 k11 = _mm_load_ps(rows.blockK11 + first);
+    __m128 k12 = _mm_load_ps(rows.blockK12 + first);
+    __m128 k22 = _mm_load_ps(rows.blockK22 + first);
+    __m128 b1 = _mm_sub_ps(_mm_sub_ps(speed1, bias1), _mm_add_ps(_mm_mul_ps(k11, old1), _mm_mul_ps(k12, old2)));
+    __m128 b2 = _mm_sub_ps(_mm_sub_ps(speed2, bias2), _mm_add_ps(_mm_mul_ps(k12, old1), _mm_mul_ps(k22, old2)));
+    __m128 massB12 = _mm_load_ps(rows.blockMass12 + first);
+    __m128 both1 = _mm_xor_ps(sign, _mm_add_ps(_mm_mul_ps(_mm_load_ps(rows.blockMass11 + first), b1), _mm_mul_ps(massB12, b2)));
+    __m128 both2 = _mm_xor_ps(sign, _mm_add_ps(_mm_mul_ps(massB12, b1), _mm_mul_ps(_mm_load_ps(rows.blockMass22 + first), b2)));
+    __m128 only1 = _mm_xor_ps(sign, _mm_mul_ps(mass1, b1));
+    __m128 only2 = _mm_xor_ps(sign, _mm_mul_ps(mass2, b2));
+    __m128 bothFits = _mm_and_ps(_mm_cmpge_ps(both1, zero), _mm_cmpge_ps(both2, zero));
+    __m128 only1Fits = _mm_and_ps(_mm_cmpge_ps(only1, zero), _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(k12, only1), b2), zero));
+    __m128 only2Fits = _mm_and_ps(_mm_cmpge_ps(only2, zero), _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(k12, only2), b1), zero));
+    __m128 noneFits = _mm_and_ps(_mm_cmpge_ps(b1, zero), _mm_cmpge_ps(b2, zero));
+
+    // Later cases first so the earlier ones win
+    __m128 normal1 = selectSse(_mm_or_ps(noneFits, only2Fits), zero, old1);
+    __m128 normal2 = selectSse(noneFits, zero, old2);
+    normal2 = selectSse(only2Fits, only2, normal2);
+    normal1 = selectSse(only1Fits, only1, normal1);
+    normal2 = selectSse(only1Fits, zero, normal2);
+    normal1 = selectSse(bothFits, both1, normal1);
+    normal2 = selectSse(bothFits, both2, normal2);
+    __m128 block = maskSse(point2.active + first);
+    normal1 = selectSse(block, normal1, single);
+    normal2 = selectSse(block, normal2, old2);
+
+    __m128 delta1 = _mm_sub_ps(normal1, old1);
+    applyImpulseSse(a, b, rows, point1, first, maskSse(point1.active + first), _mm_mul_ps(delta1, normalX), _mm_mul_ps(delta1, normalY));
+    __m128 delta2 = _mm_sub_ps(normal2, old2);
+    applyImpulseSse(a, b, rows, point2, first, block, _mm_mul_ps(delta2, normalX), _mm_mul_ps(delta2, normalY));
+    _mm_store_ps(point1.normalImpulse + first, normal1);
+    _mm_store_ps(point2.normalImpulse + first, normal2);
+}
+
+void warmStartSse(VelocitiesSse &a, VelocitiesSse &b, ContactRows &rows, size_t first) {
+    warmStartPointSse(a, b, rows, rows.points[0], first);
+    warmStartPointSse(a, b, rows, rows.points[1], first);
+}
+
+void solveContactSse(VelocitiesSse &a, VelocitiesSse &b, ContactRows &rows, size_t first) {
+    solveFrictionSse(a, b, rows, rows.points[0], first);
+    solveFrictionSse(a, b, rows, rows.points[1], first);
+    solveNormalsSse(a, b, rows, first);
+}
+
+// Rows are filled from lane 0, so a group of lanes without a first point is empty
+template<typename ContactFn>
+void forEachGroupSse(ContactRows *rows, size_t rowCount, RigidBodies &bodies, ContactFn&& contactFn) {
+    for (size_t row = 0; row < rowCount; row++) {
+        for (size_t first = 0; first < CONTACT_LANES && rows[row].points[0].active[first] != 0; first += SSE_LANES) {
+            VelocitiesSse a = gatherSse(bodies, rows[row].bodyA + first);
+            VelocitiesSse b = gatherSse(bodies, rows[row].bodyB + first);
+            contactFn(a, b, rows[row], first);
+            scatterSse(bodies, rows[row].bodyA + first, rows[row].movesA + first, a);
+            scatterSse(bodies, rows[row].bodyB + first, rows[row].movesB + first, b);
+        }
+    }
+}
+#endif
+
+#ifdef SOLVER_HAS_AVX2
+struct VelocitiesAvx {
+    __m256 vx, vy, omega;
+};
+
+__attribute__((target("avx2")))
+__m256 maskAvx(const uint32_t *mask) {
+    return _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(mask)));
+}
+
+__attribute__((target("avx2")))
+VelocitiesAvx gatherAvx(const RigidBodies &bodies, const uint32_t *index) {
+    __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(index));
+    return { _mm256_i32gather_ps(bodies.vx.data(), lanes, 4), _mm256_i32gather_ps(bodies.vy.data(), lanes, 4),
+        _mm256_i32gather_ps(bodies.omega.data(), lanes, 4) };
+}
+
+__attribute__((target("avx2")))
+void scatterAvx(RigidBodies &bodies, const uint32_t *index, const uint32_t *moves, const VelocitiesAvx &velocities) {
+    alignas(32) float vx[CONTACT_LANES], vy[CONTACT_LANES], omega[CONTACT_LANES];
+    _mm256_store_ps(vx, velocities.vx);
+    _mm256_store_ps(vy, velocities.vy);
+    _mm256_store_ps(omega, velocities.omega);
+    for (size_t lane = 0; lane < CONTACT_LANES; lane++) {
+        if (moves[lane] != 0) {
+            bodies.vx[index[lane]] = vx[lane];
+            bodies.vy[index[lane]] = vy[lane];
+            bodies.omega[index[lane]] = omega[lane];
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+__m256 relativeSpeedAvx(const VelocitiesAvx &a, const VelocitiesAvx &b, const ContactRows::Point &point,
+    __m256 directionX, __m256 directionY) {
+    __m256 x = _mm256_sub_ps(_mm256_add_ps(b.vx, _mm256_mul_ps(b.omega, _mm256_load_ps(point.perpBX))),
+        _mm256_add_ps(a.vx, _mm256_mul_ps(a.omega, _mm256_load_ps(point.perpAX))));
+    __m256 y = _mm256_sub_ps(_mm256_add_ps(b.vy, _mm256_mul_ps(b.omega, _mm256_load_ps(point.perpBY))),
+        _mm256_add_ps(a.vy, _mm256_mul_ps(a.omega, _mm256_load_ps(point.perpAY))));
+    return _mm256_add_ps(_mm256_mul_ps(x, directionX), _mm256_mul_ps(y, directionY));
+}
+
+__attribute__((target("avx2")))
+void applyImpulseAvx(VelocitiesAvx &a, VelocitiesAvx &b, const ContactRows &rows, const ContactRows::Point &point,
+    __m256 active, __m256 impulseX, __m256 impulseY) {
+    __m256 movesA = _mm256_and_ps(active, maskAvx(rows.movesA));
+    __m256 invMassA = _mm256_load_ps(rows.invMassA);
+    __m256 crossA = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(point.perpAX), impulseX),
+        _mm256_mul_ps(_mm256_load_ps(point.perpAY), impulseY));
+    a.vx = _mm256_blendv_ps(a.vx, _mm256_sub_ps(a.vx, _mm256_mul_ps(impulseX, invMassA)), movesA);
+    a.vy = _mm256_blendv_ps(a.vy, _mm256_sub_ps(a.vy, _mm256_mul_ps(impulseY, invMassA)), movesA);
+    a.omega = _mm256_blendv_ps(a.omega, _mm256_sub_ps(a.omega, _mm256_mul_ps(crossA, _mm256_load_ps(rows.invInertiaA))), movesA);
+
+    __m256 movesB = _mm256_and_ps(active, maskAvx(rows.movesB));
+    __m256 invMassB = _mm256_load_ps(rows.invMassB);
+    __m256 crossB = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(point.perpBX), impulseX),
+        _mm256_mul_ps(_mm256_load_ps(point.perpBY), impulseY));
+    b.vx = _mm256_blendv_ps(b.vx, _mm256_add_ps(b.vx, _mm256_mul_ps(impulseX, invMassB)), movesB);
+    b.vy = _mm256_blendv_ps(b.vy, _mm256_add_ps(b.vy, _mm256_mul_ps(impulseY, invMassB)), movesB);
+    b.omega = _mm256_blendv_ps(b.omega, _mm256_add_ps(b.omega, _mm256_mul_ps(crossB, _mm256_load_ps(rows.invInertiaB))), movesB);
+}
+
+__attribute__((target("avx2")))
+void warmStartPointAvx(VelocitiesAvx &a, VelocitiesAvx &b, const ContactRows &rows, const ContactRows::Point &point) {
+    __m256 normalImpulse = _mm256_load_ps(point.normalImpulse);
+    __m256 tangentImpulse = _mm256_load_ps(point.tangentImpulse);
+    __m256 impulseX = _mm256_add_ps(_mm256_mul_ps(normalImpulse, _mm256_load_ps(rows.normalX)),
+        _mm256_mul_ps(tangentImpulse, _mm256_load_ps(rows.tangentX)));
+    __m256 impulseY = _mm256_add_ps(_mm256_mul_ps(normalImpulse, _mm256_load_ps(rows.normalY)),
+        _mm256_mul_ps(tangentImpulse, _mm256_load_ps(rows.tangentY)));
+    applyImpulseAvx(a, b, rows, point, maskAvx(point.active), impulseX, impulseY);
+}
+
+__attribute__((target("avx2")))
+void solveFrictionAvx(VelocitiesAvx &a, VelocitiesAvx &b, const ContactRows &rows, ContactRows::Point &point) {
+    __m256 active = maskAvx(point.active);
+    __m256 tangentX = _mm256_load_ps(rows.tangentX);
+    __m256 tangentY = _mm256_load_ps(rows.tangentY);
+    __m256 normalImpulse = _mm256_load_ps(point.normalImpulse);
+    __m256 tangentImpulse = _mm256_load_ps(point.tangentImpulse);
+    __m256 sign = _mm256_set1_ps(-0.0f);
+
+    __m256 tangentSpeed = relativeSpeedAvx(a, b, point, tangentX, tangentY);
+    __m256 tangent = _mm256_sub_ps(tangentImpulse, _mm256_mul_ps(_mm256_load_ps(point.tangentMass), tangentSpeed));
+    __m256 sliding = _mm256_cmp_ps(_mm256_andnot_ps(sign, tangent),
+        _mm256_mul_ps(_mm256_load_ps(rows.staticFriction), normalImpulse), _CMP_GT_OQ);
+    __m256 limit = _mm256_mul_ps(_mm256_load_ps(rows.dynamicFriction), normalImpulse);
+    __m256 lowest = _mm256_xor_ps(sign, limit);
+    __m256 clamped = _mm256_blendv_ps(_mm256_blendv_ps(tangent, limit, _mm256_cmp_ps(limit, tangent, _CMP_LT_OQ)),
+        lowest, _mm256_cmp_ps(tangent, lowest, _CMP_LT_OQ));
+    tangent = _mm256_blendv_ps(tangent, clamped, sliding);
+    __m256 tangentDelta = _mm256_sub_ps(tangent, tangentImpulse);
+    applyImpulseAvx(a, b, rows, point, active, _mm256_mul_ps(tangentDelta, tangentX), _mm256_mul_ps(tangentDelta, tangentY));
+    _mm256_store_ps(point.tangentImpulse, tangent);
+}
+
+__attribute__((target("avx2")))
+void solveNormalsAvx(VelocitiesAvx &a, VelocitiesAvx &b, ContactRows &rows) {
+    ContactRows::Point &point1 = rows.points[0];
+    ContactRows::Point &point2 = rows.points[1];
+    __m256 normalX = _mm256_load_ps(rows.normalX);
+    __m256 normalY = _mm256_load_ps(rows.normalY);
+    __m256 old1 = _mm256_load_ps(point1.normalImpulse);
+    __m256 old2 = _mm256_load_ps(point2.normalImpulse);
+    __m256 mass1 = _mm256_load_ps(point1.normalMass);
+    __m256 mass2 = _mm256_load_ps(point2.normalMass);
+    __m256 bias1 = _mm256_load_ps(point1.velocityBias);
+    __m256 bias2 = _mm256_load_ps(point2.velocityBias);
+    __m256 speed1 = relativeSpeedAvx(a, b, point1, normalX, normalY);
+    __m256 speed2 = relativeSpeedAvx(a, b, point2, normalX, normalY);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 sign = _mm256_set1_ps(-0.0f);
+
+    __m256 single = _mm256_max_ps(zero, _mm256_add_ps(old1, _mm256_mul_ps(mass1, _mm256_sub_ps(bias1, speed1))));
+
+    __m256 k11 = _mm256_load_ps(rows.blockK11);
+    __m256 k12 = _mm256_load_ps(rows.blockK12);
+    __m256 k22 = _mm256_load_ps(rows.blockK22);
+    __m256 b1 = _mm256_sub_ps(_mm256_sub_ps(speed1, bias1), _mm256_add_ps(_mm256_mul_ps(k11, old1), _mm256_mul_ps(k12, old2)));
+    __m256 b2 = _mm256_sub_ps(_mm256_sub_ps(speed2, bias2), _mm256_add_ps(_mm256_mul_ps(k12, old1), _mm256_mul_ps(k22, old2)));
+    __m256 massB12 = _mm256_load_ps(rows.blockMass12);
+    __m256 both1 = _mm256_xor_ps(sign, _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(rows.blockMass11), b1), _mm256_mul_ps(massB12, b2)));
+    __m256 both2 = _mm256_xor_ps(sign, _mm256_add_ps(_mm256_mul_ps(massB12, b1), _mm256_mul_ps(_mm256_load_ps(rows.blockMass22), b2)));
+    __m256 only1 = _mm256_xor_ps(sign, _mm256_mul_ps(mass1, b1));
+    __m256 only2 = _mm256_xor_ps(sign, _mm256_mul_ps(mass2, b2));
+    __m256 bothFits = _mm256_and_ps(_mm256_cmp_ps(both1, zero, _CMP_GE_OQ), _mm256_cmp_ps(both2, zero, _CMP_GE_OQ));
+    __m256 only1Fits = _mm256_and_ps(_mm256_cmp_ps(only1, zero, _CMP_GE_OQ),
+        _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(k12, only1), b2), zero, _CMP_GE_OQ));
+    __m256 only2Fits = _mm256_and_ps(_mm256_cmp_ps(only2, zero, _CMP_GE_OQ),
+        _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(k12, only2), b1), zero, _CMP_GE_OQ));
+    __m256 noneFits = _mm256_and_ps(_mm256_cmp_ps(b1, zero, _CMP_GE_OQ), _mm256_cmp_ps(b2, zero, _CMP_GE_OQ));
+
+    __m256 normal1 = _mm256_blendv_ps(old1, zero, _mm256_or_ps(noneFits, only2Fits));
+    __m256 normal2 = _mm256_blendv_ps(old2, zero, noneFits);
+    normal2 = _mm256_blendv_ps(normal2, only2, only2Fits);
+    normal1 = _mm256_blendv_ps(normal1, only1, only1Fits);
+    normal2 = _mm256_blendv_ps(normal2, zero, only1Fits);
+    normal1 = _mm256_blendv_ps(normal1, both1, bothFits);
+    normal2 = _mm256_blendv_ps(normal2, both2, bothFits);
+    __m256 block = maskAvx(point2.active);
+    normal1 = _mm256_blendv_ps(single, normal1, block);
+    normal2 = _mm256_blendv_ps(old2, normal2, block);
+
+    __m256 delta1 = _mm256_sub_ps(normal1, old1);
+    applyImpulseAvx(a, b, rows, point1, maskAvx(point1.active), _mm256_mul_ps(delta1, normalX), _mm256_mul_ps(delta1, normalY));
+    __m256 delta2 = _mm256_sub_ps(normal2, old2);
+    applyImpulseAvx(a, b, rows, point2, block, _mm256_mul_ps(delta2, normalX), _mm256_mul_ps(delta2, normalY));
+    _mm256_store_ps(point1.normalImpulse, normal1);
+    _mm256_store_ps(point2.normalImpulse, normal2);
+}
+
+__attribute__((target("avx2")))
+void warmStartAvx2(ContactRows *rows, size_t rowCount, RigidBodies &bodies) {
+    for (size_t row = 0; row < rowCount; row++) {
+        VelocitiesAvx a = gatherAvx(bodies, rows[row].bodyA);
+        VelocitiesAvx b = gatherAvx(bodies, rows[row].bodyB);
+        warmStartPointAvx(a, b, rows[row], rows[row].points[0]);
+        warmStartPointAvx(a, b, rows[row], rows[row].points[1]);
+        scatterAvx(bodies, rows[row].bodyA, rows[row].movesA, a);
+        scatterAvx(bodies, rows[row].bodyB, rows[row].movesB, b);
+    }
+}
+
+__attribute__((target("avx2")))
+void solveVelocitiesAvx2(ContactRows *rows, size_t rowCount, RigidBodies &bodies) {
+    for (size_t row = 0; row < rowCount; row++) {
+        VelocitiesAvx a = gatherAvx(bodies, rows[row].bodyA);
+        VelocitiesAvx b = gatherAvx(bodies, rows[row].bodyB);
+        solveFrictionAvx(a, b, rows[row], rows[row].points[0]);
+        solveFrictionAvx(a, b, rows[row], rows[row].points[1]);
+        solveNormalsAvx(a, b, rows[row]);
+        scatterAvx(bodies, rows[row].bodyA, rows[row].movesA, a);
+        scatterAvx(bodies, rows[row].bodyB, rows[row].movesB, b);
+    }
+}
+#endif
+
+}
+
+void SolverKernels::warmStart(SatKernels::Kind kind, ContactRows *rows, size_t rowCount, RigidBodies &bodies) {
+    switch (kind) {
+#ifdef SOLVER_HAS_AVX2
+    case SatKernels::Kind::AVX2:
+        warmStartAvx2(rows, rowCount, bodies);
+        return;
+#endif
+#ifdef SOLVER_HAS_SSE2
+    case SatKernels::Kind::SSE2:
+        forEachGroupSse(rows, rowCount, bodies, warmStartSse);
+        return;
+#endif
+    default:
+        assert(!"no row kernel for this kind");
+        return;
+    }
+}
+
+void SolverKernels::solveVelocities(SatKernels::Kind kind, ContactRows *rows, size_t rowCount, RigidBodies &bodies) {
+    switch (kind) {
+#ifdef SOLVER_HAS_AVX2
+    case SatKernels::Kind::AVX2:
+        solveVelocitiesAvx2(rows, rowCount, bodies);
+        return;
+#endif
+#ifdef SOLVER_HAS_SSE2
+    case SatKernels::Kind::SSE2:
+        forEachGroupSse(rows, rowCount, bodies, solveContactSse);
+        return;
+#endif
+    default:
+        assert(!"no row kernel for this kind");
+        return;
+    }
+}
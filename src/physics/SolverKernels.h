@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "RigidBodies.h"
+#include "SatKernels.h"
+
+// Contacts solved together by one row
+constexpr size_t CONTACT_LANES = 8;
+
+// Up to CONTACT_LANES contacts of one color, stored field by field with one
+// lane per contact. The lanes never share a moving body, so the solver
+// kernels update every lane at once and gather and scatter the body
+// velocities around it. Masks are all bits set where they apply and zero
+// elsewhere. Unused lanes have every mask cleared and repeat the bodies of
+// the last used lane so that gathers stay in range.
+struct alignas(32) ContactRows {
+    struct Point {
+        uint32_t active[CONTACT_LANES];
+        // Offsets from each body's center to the point, turned a quarter counterclockwise
+        float perpAX[CONTACT_LANES], perpAY[CONTACT_LANES];
+        float perpBX[CONTACT_LANES], perpBY[CONTACT_LANES];
+        float normalMass[CONTACT_LANES], tangentMass[CONTACT_LANES];
+        float velocityBias[CONTACT_LANES];
+        float normalImpulse[CONTACT_LANES], tangentImpulse[CONTACT_LANES];
+    };
+
+    uint32_t bodyA[CONTACT_LANES], bodyB[CONTACT_LANES];
+    // Cleared for static bodies, which are only read
+    uint32_t movesA[CONTACT_LANES], movesB[CONTACT_LANES];
+    float normalX[CONTACT_LANES], normalY[CONTACT_LANES];
+    float tangentX[CONTACT_LANES], tangentY[CONTACT_LANES];
+    float invMassA[CONTACT_LANES], invMassB[CONTACT_LANES];
+    float invInertiaA[CONTACT_LANES], invInertiaB[CONTACT_LANES];
+    float staticFriction[CONTACT_LANES], dynamicFriction[CONTACT_LANES];
+    // Effective mass matrix of lanes with both points and its inverse, see ContactConstraint
+    float blockK11[CONTACT_LANES], blockK12[CONTACT_LANES], blockK22[CONTACT_LANES];
+    float blockMass11[CONTACT_LANES], blockMass12[CONTACT_LANES], blockMass22[CONTACT_LANES];
+    Point points[2];
+};
+
+// Contact solver passes over rows. They do the same operations in the same
+// order as ContactSolver's one contact at a time loop, so without fused
+// multiply-add they round exactly like it. Kernels come in the flavours of
+// the separating axis ones and run where those are supported. The scalar
+// kind has no row kernel, ContactSolver keeps its own loop for it.
+namespace SolverKernels {
+    // Applies the accumulated impulses of rows[0, rowCount) to the bodies
+    void warmStart(SatKernels::Kind kind, ContactRows *rows, size_t rowCount, RigidBodies &bodies);
+    // One velocity iteration over rows[0, rowCount), friction for each point
+    // then the normal impulses, of both points together where there are two
+    void solveVelocities(SatKernels::Kind kind, ContactRows *rows, size_t rowCount, RigidBodies &bodies);
+}
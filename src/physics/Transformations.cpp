@@ -1,6 +1,5 @@
 #include "Transformations.h"
 
-#include <iostream>
 #include <glm/ext/matrix_clip_space.hpp>
 
 #include "glm/ext/matrix_transform.hpp"
@@ -27,18 +26,31 @@ std::vector<glm::vec3> Transformations::getWorldVertices(const std::vector<glm::
     return worldVertices;
 }
 
+void Transformations::computeWorldVertices(const ShapeVertices &localVertices, const glm::mat4 &transformationMatrix, ShapeVertices &worldVertices) {
+    worldVertices.clear();
+    for (const auto &vertex : localVertices) {
+        glm::vec4 transformedVertex = transformationMatrix * glm::vec4(vertex, 1.0f);
+        worldVertices.push_back(glm::vec3(transformedVertex));
+    }
+}
+
+void Transformations::computeEdgeNormals(const ShapeVertices &vertices, ShapeVertices &normals) {
+    normals.clear();
+    for (size_t i = 0; i < vertices.size(); i++) {
+        size_t next = i + 1 == vertices.size() ? 0 : i + 1;
+        glm::vec3 edge = vertices[next] - vertices[i];
+        normals.push_back(glm::normalize(glm::vec3(-edge.y, edge.x, 0.0f)));
+    }
+}
+
 float Transformations::cross(const glm::vec2& a, const glm::vec2& b) {
     return a.x * b.y - a.y * b.x;
 }
 
 float Transformations::calculateCircleInertia(float mass, float radius) {
-    std::cout << "Radius: " << radius << std::endl;
     return 0.5f * mass * radius * radius;
 }
 
 float Transformations::calculateBoxInertia(float mass, float width, float height) {
-    std::cout << "Width: " << width << std::endl;
-    std::cout << "Height: " << height << std::endl;
-
     return (1.0f / 12.0f) * mass * (width * width + height * height);
 }
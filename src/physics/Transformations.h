@@ -2,11 +2,16 @@
 
 #include <vector>
 #include "glm/glm.hpp"
+#include "ShapeVertices.h"
 
 namespace Transformations {
     void updateMatrix(glm::mat4 &transformationMatrix, const glm::vec3 &centerOfMass, float rotation);
     glm::mat4 createProjectionMatrix(int width, int height);
     std::vector<glm::vec3> getWorldVertices(const std::vector<glm::vec3> &localVertices, const glm::mat4 &transformationMatrix);
+    // Same as getWorldVertices, writing into worldVertices to reuse its memory
+    void computeWorldVertices(const ShapeVertices &localVertices, const glm::mat4 &transformationMatrix, ShapeVertices &worldVertices);
+    // Unit normal of every edge, normals[i] for the edge from vertices[i] to vertices[i + 1]
+    void computeEdgeNormals(const ShapeVertices &vertices, ShapeVertices &normals);
     float cross(const glm::vec2& a, const glm::vec2& b);
     float calculateCircleInertia(float mass, float radius);
     float calculateBoxInertia(float mass, float width, float height);
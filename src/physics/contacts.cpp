@@ -1,4 +1,6 @@
+#include <cassert>
 #include <cmath>
+#include <limits>
 
 #include "glm/vec3.hpp"
 #include "glm/detail/func_geometric.inl"
@@ -8,6 +10,18 @@
 
 // Value to account for floating point innacuracies
 static constexpr float inaccuracyCheck = 0.000005f;
+// How much better B's face has to fit the normal to become the reference face
+static constexpr float referenceFaceBias = 0.0005f;
+
+template<size_t Count>
+static size_t vertexCount(const ShapeVertices &vertices) {
+    assert(Count == 0 || vertices.size() == Count);
+    return Count != 0 ? Count : vertices.size();
+}
+
+static size_t nextVertex(size_t index, size_t count) {
+    return index + 1 == count ? 0 : index + 1;
+}
 
 ContactInfo pointSegmentDistance(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b) {
     glm::vec3 ab = b - a;
@@ -35,13 +49,15 @@ ContactInfo pointSegmentDistance(const glm::vec3 &p, const glm::vec3 &a, const g
     };
 }
 
-glm::vec3 contactPointCirclevsBox(const glm::vec3 &circleCenter, const std::vector<glm::vec3> &boxVertices) {
+template<size_t Count>
+glm::vec3 contactPointCirclevsBox(const glm::vec3 &circleCenter, const ShapeVertices &boxVertices) {
     float minDistSq = std::numeric_limits<float>::max();
     glm::vec3 contactPoint{};
 
-    for (int i = 0; i < boxVertices.size(); i++) {
+    size_t count = vertexCount<Count>(boxVertices);
+    for (size_t i = 0; i < count; i++) {
         glm::vec3 va = boxVertices[i];
-        glm::vec3 vb = boxVertices[(i + 1) % boxVertices.size()];
+        glm::vec3 vb = boxVertices[nextVertex(i, count)];
 
         ContactInfo contactInfo = pointSegmentDistance(circleCenter, va, vb);
 
@@ -53,52 +69,102 @@ glm::vec3 contactPointCirclevsBox(const glm::vec3 &circleCenter, const std::vect
     return contactPoint;
 }
 
-ContactPoints contactPointsBoxBox(const std::vector<glm::vec3> &verticesA, const std::vector<glm::vec3> &verticesB) {
-    ContactPoints result {};
-    float minDistSq = std::numeric_limits<float>::max();
+// Sign that turns the edge normals of a polygon outward, whatever its winding
+static float outwardSign(const ShapeVertices &vertices, const ShapeVertices &normals, size_t count) {
+    glm::vec3 center(0.0f);
+    for (size_t i = 0; i < count; i++) {
+        center += vertices[i];
+    }
+    center /= static_cast<float>(count);
+    glm::vec3 midpoint = (vertices[0] + vertices[nextVertex(0, count)]) * 0.5f;
+    return glm::dot(normals[0], midpoint - center) >= 0.0f ? 1.0f : -1.0f;
+}
 
-    for (int i = 0; i < verticesA.size(); i++) {
-        glm::vec3 p = verticesA[i];
-
-        for (int j = 0; j < verticesB.size(); j++) {
-            glm::vec3 va = verticesB[j];
-            glm::vec3 vb = verticesB[(j + 1) % verticesB.size()];
-
-            ContactInfo contactInfo = pointSegmentDistance(p, va, vb);
-            if (std::abs(glm::length(contactInfo.distanceSquared - minDistSq)) < inaccuracyCheck) {
-                if (std::abs(glm::length(contactInfo.contact - result.contact1)) > inaccuracyCheck) {
-                    result.contact2 = contactInfo.contact;
-                    result.nContacts = 2;
-                }
-            } else if (contactInfo.distanceSquared < minDistSq) {
-                minDistSq = contactInfo.distanceSquared;
-                result.nContacts = 1;
-                result.contact1 = contactInfo.contact;
-            }
+// Edge whose outward normal is closest to direction, and how close it is
+static size_t mostAlignedEdge(const ShapeVertices &normals, size_t count, float sign, const glm::vec3 &direction, float &alignment) {
+    size_t best = 0;
+    alignment = -std::numeric_limits<float>::max();
+    for (size_t i = 0; i < count; i++) {
+        float dot = sign * glm::dot(normals[i], direction);
+        if (dot > alignment) {
+            alignment = dot;
+            best = i;
         }
     }
+    return best;
+}
+
+// Keeps the part of the segment where dot(p, tangent) >= offset
+static bool clipSegment(glm::vec3 segment[2], const glm::vec3 &tangent, float offset) {
+    float d0 = glm::dot(segment[0], tangent) - offset;
+    float d1 = glm::dot(segment[1], tangent) - offset;
+    if (d0 < 0.0f && d1 < 0.0f) {
+        return false;
+    }
+    if (d0 < 0.0f) {
+        segment[0] = segment[0] + (segment[1] - segment[0]) * (d0 / (d0 - d1));
+    } else if (d1 < 0.0f) {
+        segment[1] = segment[1] + (segment[0] - segment[1]) * (d1 / (d1 - d0));
+    }
+    return true;
+}
 
-    for (int i = 0; i < verticesB.size(); i++) {
-        glm::vec3 p = verticesB[i];
-
-        for (int j = 0; j < verticesA.size(); j++) {
-            glm::vec3 va = verticesA[j];
-            glm::vec3 vb = verticesA[(j + 1) % verticesA.size()];
-
-            ContactInfo contactInfo = pointSegmentDistance(p, va, vb);
-            if (std::abs(glm::length(contactInfo.distanceSquared - minDistSq)) < inaccuracyCheck) {
-                if (std::abs(glm::length(contactInfo.contact - result.contact1)) > inaccuracyCheck) {
-                    result.contact2 = contactInfo.contact;
-                    result.nContacts = 2;
-                }
-            } else if (contactInfo.distanceSquared < minDistSq) {
-                minDistSq = contactInfo.distanceSquared;
-                result.nContacts = 1;
-                result.contact1 = contactInfo.contact;
-            }
-        }
+// normal points from A to B. The reference face is the face of either polygon
+// facing the other along normal, the incident face the one of the other polygon
+// facing back. The incident face is clipped to the sides of the reference face
+// and the points left behind it are the contacts, so touching faces give the
+// two ends of their overlap.
+template<size_t CountA, size_t CountB>
+ContactPoints contactPointsBoxBox(const ShapeVertices &verticesA, const ShapeVertices &normalsA,
+    const ShapeVertices &verticesB, const ShapeVertices &normalsB, const glm::vec3 &normal) {
+    ContactPoints result {};
+    size_t countA = vertexCount<CountA>(verticesA);
+    size_t countB = vertexCount<CountB>(verticesB);
+    float signA = outwardSign(verticesA, normalsA, countA);
+    float signB = outwardSign(verticesB, normalsB, countB);
+
+    float alignmentA, alignmentB;
+    size_t edgeA = mostAlignedEdge(normalsA, countA, signA, normal, alignmentA);
+    size_t edgeB = mostAlignedEdge(normalsB, countB, signB, -normal, alignmentB);
+
+    // Prefer A unless B is clearly better, so the reference face does not flip between steps
+    bool referenceIsA = alignmentA + referenceFaceBias >= alignmentB;
+    const ShapeVertices &reference = referenceIsA ? verticesA : verticesB;
+    const ShapeVertices &incident = referenceIsA ? verticesB : verticesA;
+    const ShapeVertices &incidentNormals = referenceIsA ? normalsB : normalsA;
+    size_t referenceCount = referenceIsA ? countA : countB;
+    size_t incidentCount = referenceIsA ? countB : countA;
+    size_t referenceEdge = referenceIsA ? edgeA : edgeB;
+    glm::vec3 referenceNormal = referenceIsA ? signA * normalsA[edgeA] : signB * normalsB[edgeB];
+    float incidentSign = referenceIsA ? signB : signA;
+
+    float alignment;
+    size_t incidentEdge = mostAlignedEdge(incidentNormals, incidentCount, incidentSign, -referenceNormal, alignment);
+    size_t incidentVertices[2] = { incidentEdge, nextVertex(incidentEdge, incidentCount) };
+    glm::vec3 segment[2] = { incident[incidentVertices[0]], incident[incidentVertices[1]] };
+
+    glm::vec3 start = reference[referenceEdge];
+    glm::vec3 end = reference[nextVertex(referenceEdge, referenceCount)];
+    glm::vec3 tangent = end - start;
+    if (!clipSegment(segment, tangent, glm::dot(start, tangent)) || !clipSegment(segment, -tangent, glm::dot(end, -tangent))) {
+        return result;
     }
 
+    // The shape giving the vertex is the incident one
+    uint32_t side = referenceIsA ? 1 : 0;
+    glm::vec3 *contacts[2] = { &result.contact1, &result.contact2 };
+    uint32_t *features[2] = { &result.feature1, &result.feature2 };
+    float *separations[2] = { &result.separation1, &result.separation2 };
+    for (size_t i = 0; i < 2; i++) {
+        float separation = glm::dot(segment[i] - start, referenceNormal);
+        if (separation <= 0.0f) {
+            *separations[result.nContacts] = separation;
+            // Halfway between the incident point and the reference face
+            *contacts[result.nContacts] = segment[i] - referenceNormal * (separation * 0.5f);
+            *features[result.nContacts] = contactFeature(side, incidentVertices[i], referenceEdge);
+            result.nContacts++;
+        }
+    }
     return result;
 }
 
@@ -110,11 +176,13 @@ glm::vec3 contactPointCircleCircle(const glm::vec3 &centerA, float radiusA, cons
     return contactPoint;
 }
 
-int findClosestPointOnPolygon(const glm::vec3 &circleCenter, const std::vector<glm::vec3> &vertices) {
+template<size_t Count>
+int findClosestPointOnPolygon(const glm::vec3 &circleCenter, const ShapeVertices &vertices) {
     int result = -1;
     float minDistance = std::numeric_limits<float>::max();
 
-    for (int i = 0; i < vertices.size(); i++) {
+    size_t count = vertexCount<Count>(vertices);
+    for (int i = 0; i < static_cast<int>(count); i++) {
         glm::vec3 v = vertices[i];
         float distance = glm::distance(v, circleCenter);
 
@@ -127,6 +195,15 @@ int findClosestPointOnPolygon(const glm::vec3 &circleCenter, const std::vector<g
     return result;
 }
 
+template glm::vec3 contactPointCirclevsBox<0>(const glm::vec3 &, const ShapeVertices &);
+template glm::vec3 contactPointCirclevsBox<BOX_VERTICES>(const glm::vec3 &, const ShapeVertices &);
+template int findClosestPointOnPolygon<0>(const glm::vec3 &, const ShapeVertices &);
+template int findClosestPointOnPolygon<BOX_VERTICES>(const glm::vec3 &, const ShapeVertices &);
+template ContactPoints contactPointsBoxBox<0, 0>(const ShapeVertices &, const ShapeVertices &,
+    const ShapeVertices &, const ShapeVertices &, const glm::vec3 &);
+template ContactPoints contactPointsBoxBox<BOX_VERTICES, BOX_VERTICES>(const ShapeVertices &, const ShapeVertices &,
+    const ShapeVertices &, const ShapeVertices &, const glm::vec3 &);
+
 bool nearlyEqual(const glm::vec3 &v1, const glm::vec3 &v2) {
     return std::abs(glm::length(v1 - v2)) < inaccuracyCheck;
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 
 #include "glm/vec3.hpp"
+#include "ShapeVertices.h"
 
 struct ContactInfo {
     glm::vec3 contact;
@@ -11,12 +13,31 @@ struct ContactInfo {
 struct ContactPoints {
     glm::vec3 contact1;
     glm::vec3 contact2;
+    // Which vertex and edge made each contact, see contactFeature
+    uint32_t feature1;
+    uint32_t feature2;
+    // Distance of each incident point in front of the reference face, negative behind it
+    float separation1;
+    float separation2;
     int nContacts;
 };
 
+// Identifies a box contact across steps: the shape giving the incident vertex
+// (0 for A, 1 for B), that vertex and the reference edge of the other shape
+inline uint32_t contactFeature(uint32_t side, size_t vertex, size_t edge) {
+    return (side << 6) | (static_cast<uint32_t>(vertex) << 3) | static_cast<uint32_t>(edge);
+}
+
 ContactInfo pointSegmentDistance(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b);
-glm::vec3 contactPointCirclevsBox(const glm::vec3 &circleCenter, const std::vector<glm::vec3> &boxVertices);
-int findClosestPointOnPolygon(const glm::vec3 &circleCenter, const std::vector<glm::vec3> &vertices);
 glm::vec3 contactPointCircleCircle(const glm::vec3 &centerA, float radiusA, const glm::vec3 &centerB);
-ContactPoints contactPointsBoxBox(const std::vector<glm::vec3> &verticesA, const std::vector<glm::vec3> &verticesB);
+
+// The polygon routines take the vertex count as a template parameter so the
+// box case, BOX_VERTICES, unrolls. A count of 0 reads it from the vertices.
+template<size_t Count>
+glm::vec3 contactPointCirclevsBox(const glm::vec3 &circleCenter, const ShapeVertices &boxVertices);
+template<size_t Count>
+int findClosestPointOnPolygon(const glm::vec3 &circleCenter, const ShapeVertices &vertices);
+template<size_t CountA, size_t CountB>
+ContactPoints contactPointsBoxBox(const ShapeVertices &verticesA, const ShapeVertices &normalsA,
+    const ShapeVertices &verticesB, const ShapeVertices &normalsB, const glm::vec3 &normal);
 bool nearlyEqual(const glm::vec3 &v1, const glm::vec3 &v2);
\ No newline at end of file
@@ -42,7 +42,7 @@ void projectPolygon(const std::vector<glm::vec3>& vertices, const glm::vec3& axi
     }
 }
 
-void projectCircle(const glm::vec3 &center, float radius, glm::vec3 &axis, float &min, float &max){
+void projectCircle(const glm::vec3 &center, float radius, const glm::vec3 &axis, float &min, float &max){
     glm::vec3 direction = glm::normalize(axis);
 
     glm::vec3 p1 = center + direction * radius;
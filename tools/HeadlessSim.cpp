@@ -0,0 +1,163 @@
+// Runs a world without a window or GL context. The scene is loaded from a
+// snapshot or generated, then stepped as fast as possible with the same fixed
+// step as the editor. The run is printed as JSON and the final scene can be
+// saved. Exits with 1 on bad arguments or when a snapshot cannot be read or written.
+//
+//   headless_sim [--load scene.snapshot | --bodies N] [--steps N] [--dt seconds]
+//                [--substeps N] [--threads N] [--save out.snapshot]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "World.h"
+
+namespace {
+
+struct Options {
+    std::string loadPath;
+    std::string savePath;
+    size_t bodyCount = 1000;
+    size_t stepCount = 1000;
+    float stepSeconds = 1.0f / 60.0f;
+    int substeps = 2;
+    unsigned int solverThreads = 1;
+};
+
+const size_t COLUMNS = 100;
+
+using Clock = std::chrono::steady_clock;
+
+void printUsage() {
+    std::cerr << "Usage: headless_sim [--load scene.snapshot | --bodies N] [--steps N] [--dt seconds]\n"
+                 "                    [--substeps N] [--threads N] [--save out.snapshot]\n"
+                 "  --threads 0 solves contacts on every core\n";
+}
+
+bool parseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const char *flag = argv[i];
+        if (std::strcmp(flag, "--help") == 0) {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+        const char *value = argv[++i];
+        char *end = nullptr;
+        if (std::strcmp(flag, "--load") == 0) {
+            options.loadPath = value;
+            continue;
+        } else if (std::strcmp(flag, "--save") == 0) {
+            options.savePath = value;
+            continue;
+        } else if (std::strcmp(flag, "--bodies") == 0) {
+            options.bodyCount = std::strtoul(value, &end, 10);
+        } else if (std::strcmp(flag, "--steps") == 0) {
+            options.stepCount = std::strtoul(value, &end, 10);
+        } else if (std::strcmp(flag, "--dt") == 0) {
+            options.stepSeconds = std::strtof(value, &end);
+        } else if (std::strcmp(flag, "--substeps") == 0) {
+            options.substeps = static_cast<int>(std::strtol(value, &end, 10));
+        } else if (std::strcmp(flag, "--threads") == 0) {
+            options.solverThreads = static_cast<unsigned int>(std::strtoul(value, &end, 10));
+        } else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return false;
+        }
+        if (end == value || *end != '\0') {
+            std::cerr << "Bad value " << value << " for " << flag << std::endl;
+            return false;
+        }
+    }
+    if (options.stepSeconds <= 0.0f || options.substeps < 1) {
+        std::cerr << "--dt must be positive and --substeps at least 1" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Boxes and circles dropped in rows into a walled floor
+// Escapes text for a JSON string, paths may hold quotes, backslashes or control characters
+std::string jsonEscape(const std::string &text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void generatePile(World &world, size_t bodyCount) {
+    world.insertStaticBox(glm::vec3(0.0f, -3.0f, 0.0f), 12.0f, 0.2f, glm::vec4(1.0f));
+    world.insertStaticBox(glm::vec3(-6.0f, 0.0f, 0.0f), 0.2f, 6.0f, glm::vec4(1.0f));
+    world.insertStaticBox(glm::vec3(6.0f, 0.0f, 0.0f), 0.2f, 6.0f, glm::vec4(1.0f));
+    for (size_t i = 0; i < bodyCount; i++) {
+        float x = -5.5f + 0.11f * float(i % COLUMNS) + 0.01f * float((i / COLUMNS) % 2);
+        float y = -2.8f + 0.11f * float(i / COLUMNS);
+        if (i % 3 == 0) {
+            world.insertCircle(x, y, 0.05f, glm::vec4(1.0f));
+        } else {
+            world.insertBox(glm::vec3(x, y, 0.0f), 0.1f, 0.1f, glm::vec4(1.0f));
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    World world;
+    if (!options.loadPath.empty()) {
+        if (!world.loadSnapshot(options.loadPath)) {
+            std::cerr << "Could not load " << options.loadPath << std::endl;
+            return 1;
+        }
+    } else {
+        generatePile(world, options.bodyCount);
+    }
+    world.setSolverThreads(options.solverThreads);
+    // One fixed step per advance call, never capped
+    world.setFixedStep(options.stepSeconds, options.substeps, 1);
+
+    Clock::time_point start = Clock::now();
+    for (size_t step = 0; step < options.stepCount; step++) {
+        world.advance(options.stepSeconds);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const RigidBodies &bodies = world.scene().rigidBodies;
+    size_t awake = 0;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        awake += !bodies.isStatic(static_cast<uint32_t>(i)) && bodies.sleepIsland[i] == 0 ? 1 : 0;
+    }
+    std::printf("{\"source\": \"%s\", \"bodies\": %zu, \"awake\": %zu, \"contacts\": %zu, \"steps\": %zu, "
+        "\"substeps\": %d, \"dt\": %g, \"solver_threads\": %u, \"seconds\": %.6f, \"steps_per_second\": %.1f}\n",
+        options.loadPath.empty() ? "generated" : jsonEscape(options.loadPath).c_str(), bodies.size(), awake,
+        world.contactSolver().constraints().size(), options.stepCount, options.substeps, options.stepSeconds,
+        options.solverThreads, seconds, seconds > 0.0 ? options.stepCount / seconds : 0.0);
+
+    if (!options.savePath.empty() && !world.saveSnapshot(options.savePath)) {
+        std::cerr << "Could not save " << options.savePath << std::endl;
+        return 1;
+    }
+    return 0;
+}